@@ -21,8 +21,9 @@ AES_IV = bytes([
 ])
 # ---------------------------------------- #
 
-def pack_sensor_data(temp, speed, lat, lon):
-    return struct.pack("ffff", temp, speed, lat, lon)
+def pack_sensor_data(sensor_id, seq, temp, speed, lat, lon):
+    # sensor_record_t: sensor ID, sequence number, timestamp in microseconds, then the readings
+    return struct.pack("<IIQffff", sensor_id, seq, int(time.time() * 1e6), temp, speed, lat, lon)
 
 def encrypt_sensor_data(plaintext: bytes) -> bytes:
     cipher = AES.new(AES_KEY, AES.MODE_CBC, AES_IV)
@@ -49,8 +50,10 @@ def send_payload(payload: bytes):
         print(f"[X] Connection failed: {e}")
 
 def attacker_loop():
+    seq = 0
     while True:
-        sensor_bytes = pack_sensor_data(55.0, 80.5, 30.1234, 31.5678)
+        sensor_bytes = pack_sensor_data(1, seq, 55.0, 80.5, 30.1234, 31.5678)
+        seq += 1
         ciphertext = encrypt_sensor_data(sensor_bytes)
         good_cmac = compute_cmac(ciphertext)
         bad_cmac = corrupt_cmac(good_cmac)
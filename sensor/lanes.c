@@ -0,0 +1,183 @@
+/**
+ * @file lanes.c
+ * @brief Per-class frame queues and deadline-aware uplink scheduler, see lanes.h.
+ */
+
+#include <stdio.h>
+#include <time.h>
+
+#include "sensor_def.h"
+#include "uplink.h"
+#include "lanes.h"
+
+typedef struct
+{
+    frame_t *frame;         // Encrypted frame, owned by the lane
+    uint32_t sensor_id;
+    uint64_t enqueued_ns;
+} lane_entry_t;
+
+typedef struct
+{
+    const char *name;
+    unsigned int batch;             // Frames per flush
+    uint64_t deadline_ns;           // Longest a frame may wait before its lane is flushed
+    lane_entry_t queue[LANE_QUEUE_DEPTH];
+    unsigned int head;              // Oldest entry
+    unsigned int count;
+    // Stats
+    unsigned long enqueued;
+    unsigned long sent;
+    unsigned long dropped;          // Lane full or no receiver took the frame
+    unsigned long batches;
+    uint64_t latency_sum_ns;        // Enqueue to delivery, current stats window
+    uint64_t latency_max_ns;
+    unsigned long latency_count;
+} lane_t;
+
+static lane_t lanes[LANE_COUNT] = {
+    [LANE_URGENT] = {.name = "urgent", .batch = LANE_URGENT_BATCH, .deadline_ns = LANE_URGENT_DEADLINE_MS * 1000000ull},
+    [LANE_NORMAL] = {.name = "normal", .batch = LANE_NORMAL_BATCH, .deadline_ns = LANE_NORMAL_DEADLINE_MS * 1000000ull},
+    [LANE_BULK] = {.name = "bulk", .batch = LANE_BULK_BATCH, .deadline_ns = LANE_BULK_DEADLINE_MS * 1000000ull},
+};
+
+uint64_t lanes_now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+int lane_classify(int client_priority, uint8_t sensor_class)
+{
+    // An urgent-priority client is always honoured
+    if (client_priority >= LANE_URGENT_MIN_PRIORITY)
+        return LANE_URGENT;
+
+    switch (sensor_class)
+    {
+    case SENSOR_CLASS_SAFETY: return LANE_URGENT;
+    case SENSOR_CLASS_NORMAL: return LANE_NORMAL;
+    case SENSOR_CLASS_BULK: return LANE_BULK;
+    default: break;
+    }
+
+    // No class configured: follow the client's priority
+    return client_priority <= LANE_BULK_MAX_PRIORITY ? LANE_BULK : LANE_NORMAL;
+}
+
+int lane_enqueue(int lane, uint32_t sensor_id, frame_t *frame)
+{
+    lane_t *l = &lanes[lane];
+
+    if (l->count == LANE_QUEUE_DEPTH)
+    {
+        l->dropped++;
+        frame_free(frame);
+        return -1;
+    }
+
+    lane_entry_t *e = &l->queue[(l->head + l->count) % LANE_QUEUE_DEPTH];
+    e->frame = frame;
+    e->sensor_id = sensor_id;
+    e->enqueued_ns = lanes_now_ns();
+    l->count++;
+    l->enqueued++;
+    return 0;
+}
+
+// Send up to one batch from the head of a lane and release the frames
+static void flush_batch(lane_t *l)
+{
+    uplink_frame_t batch[UPLINK_MAX_BATCH];
+    unsigned int n = l->count < l->batch ? l->count : l->batch;
+    if (n > UPLINK_MAX_BATCH)
+        n = UPLINK_MAX_BATCH;
+
+    for (unsigned int i = 0; i < n; i++)
+    {
+        const lane_entry_t *e = &l->queue[(l->head + i) % LANE_QUEUE_DEPTH];
+        batch[i].sensor_id = e->sensor_id;
+        batch[i].data = e->frame->data;
+        batch[i].len = e->frame->len;
+    }
+
+    int sent = uplink_send_batch(batch, n);
+    uint64_t now = lanes_now_ns();
+
+    l->batches++;
+    l->sent += sent;
+    l->dropped += n - sent;
+    for (unsigned int i = 0; i < n; i++)
+    {
+        lane_entry_t *e = &l->queue[l->head];
+        uint64_t latency = now - e->enqueued_ns;
+
+        l->latency_sum_ns += latency;
+        if (latency > l->latency_max_ns)
+            l->latency_max_ns = latency;
+        l->latency_count++;
+
+        frame_free(e->frame);
+        e->frame = NULL;
+        l->head = (l->head + 1) % LANE_QUEUE_DEPTH;
+        l->count--;
+    }
+}
+
+// A lane is due when it holds a full batch or its oldest frame has reached the deadline
+static int lane_due(const lane_t *l, uint64_t now)
+{
+    return l->count >= l->batch ||
+           (l->count > 0 && now >= l->queue[l->head].enqueued_ns + l->deadline_ns);
+}
+
+uint64_t lanes_flush_due(void)
+{
+    uint64_t now = lanes_now_ns();
+    uint64_t next = 0;
+
+    // Urgent traffic is drained completely
+    while (lane_due(&lanes[LANE_URGENT], now))
+        flush_batch(&lanes[LANE_URGENT]);
+
+    // Then at most one batch of the most urgent due lane, so new urgent frames are not held up
+    for (int i = LANE_URGENT + 1; i < LANE_COUNT; i++)
+    {
+        if (lane_due(&lanes[i], now))
+        {
+            flush_batch(&lanes[i]);
+            now = lanes_now_ns();
+            break;
+        }
+    }
+
+    // Earliest moment any lane becomes due
+    for (int i = 0; i < LANE_COUNT; i++)
+    {
+        const lane_t *l = &lanes[i];
+        uint64_t due;
+
+        if (l->count == 0)
+            continue;
+        due = lane_due(l, now) ? now : l->queue[l->head].enqueued_ns + l->deadline_ns;
+        if (next == 0 || due < next)
+            next = due;
+    }
+    return next;
+}
+
+void lanes_print_stats(void)
+{
+    for (int i = 0; i < LANE_COUNT; i++)
+    {
+        lane_t *l = &lanes[i];
+        printf("Lane %-6s queued=%u enqueued=%lu sent=%lu dropped=%lu batches=%lu latency avg=%.2fms max=%.2fms\n",
+               l->name, l->count, l->enqueued, l->sent, l->dropped, l->batches,
+               l->latency_count ? l->latency_sum_ns / (double)l->latency_count / 1e6 : 0.0,
+               l->latency_max_ns / 1e6);
+        l->latency_sum_ns = 0;
+        l->latency_max_ns = 0;
+        l->latency_count = 0;
+    }
+}
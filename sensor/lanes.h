@@ -0,0 +1,73 @@
+/**
+ * @file lanes.h
+ * @brief Priority lanes feeding the uplink scheduler of the sensor server.
+ * @details
+ *  Each lane has its own queue of encrypted frames, batch size and flush deadline. A lane is
+ *  flushed when it holds a full batch or when its oldest frame reaches the deadline, so urgent
+ *  frames go out as soon as they arrive while bulk telemetry is coalesced into large batches.
+ *  Lanes are always served most urgent first, and only one non-urgent batch is sent per
+ *  scheduling pass so urgent traffic is never stuck behind a long bulk flush.
+ */
+
+#ifndef LANES_H
+#define LANES_H
+
+#include <stdint.h>
+
+#include "frame_pool.h"
+
+#define LANE_URGENT 0 // Safety-relevant readings, sent immediately
+#define LANE_NORMAL 1 // Regular readings, lightly batched
+#define LANE_BULK 2   // Bulk telemetry, coalesced
+#define LANE_COUNT 3
+
+#define LANE_QUEUE_DEPTH 256 // Frames a lane can hold before new frames are dropped
+
+// Client QNX priority to lane mapping; a configured sensor class overrides it unless the
+// client runs at urgent priority
+#define LANE_URGENT_MIN_PRIORITY 20 // Clients at or above this priority use the urgent lane
+#define LANE_BULK_MAX_PRIORITY 9    // Clients at or below this priority use the bulk lane
+
+// Batch size and flush deadline per lane
+#define LANE_URGENT_BATCH 1
+#define LANE_URGENT_DEADLINE_MS 0
+#define LANE_NORMAL_BATCH 8
+#define LANE_NORMAL_DEADLINE_MS 20
+#define LANE_BULK_BATCH 64
+#define LANE_BULK_DEADLINE_MS 500
+
+#define LANE_STATS_INTERVAL_MS 10000 // Print per-lane stats this often
+
+/*
+ * Pick the lane for a sample.
+ * client_priority: QNX priority of the sending thread (from MsgReceive)
+ * sensor_class: SENSOR_CLASS_* from the message
+ * Returns: LANE_URGENT, LANE_NORMAL or LANE_BULK
+ */
+int lane_classify(int client_priority, uint8_t sensor_class);
+
+/*
+ * Queue an encrypted frame on a lane. Ownership of the frame passes to the lane,
+ * which frees it once sent or dropped.
+ * Returns: 0 on success, -1 if the lane is full and the frame was dropped
+ */
+int lane_enqueue(int lane, uint32_t sensor_id, frame_t *frame);
+
+/*
+ * Send every due urgent batch and at most one due batch of the other lanes.
+ * Returns: CLOCK_MONOTONIC time in ns at which lanes_flush_due() must run again,
+ *          0 if nothing is queued
+ */
+uint64_t lanes_flush_due(void);
+
+/*
+ * Print per-lane queue depth, counters and queueing latency, then reset the latency window.
+ */
+void lanes_print_stats(void);
+
+/*
+ * Returns: current CLOCK_MONOTONIC time in ns
+ */
+uint64_t lanes_now_ns(void);
+
+#endif // LANES_H
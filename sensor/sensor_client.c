@@ -5,7 +5,14 @@
  *  This client simulates a sensor that generates random sensor data
  *  and sends it to a server process using QNX message passing.
  *  The sensor data includes temperature, speed, and GPS coordinates.
+ *  The sensor ID is taken from the first argument, or defaults to the process ID.
+ *  An optional second argument (safety, normal or bulk) sets the sensor class, which selects
+ *  the server's uplink lane together with the client's QNX priority.
  *  The client connects to the server using a name service and sends data periodically every 1 second.
+ *  With -n the client instead runs as a load simulator: it drives that many virtual sensors, with
+ *  consecutive IDs starting at sensor_id (required, so that simulators started side by side can be
+ *  given ranges that do not overlap), at an aggregate rate set by -r and shaped by the -p profile
+ *  (flat, burst or diurnal), for -d seconds or forever. -S fixes the seed so a run can be reproduced.
  *  The server is expected to be running and registered with the name SENSOR_NAME.
  *  The client will retry connecting to the server for up to 60 seconds.
  *  If the connection fails after 60 seconds, it will exit with an error.
@@ -23,6 +30,7 @@
 #include <sys/dispatch.h>
 
 #include "sensor_def.h"
+#include "sensor_sim.h"
 
 void generate_sensor_data(sensor_data_t *data)
 {
@@ -32,13 +40,79 @@ void generate_sensor_data(sensor_data_t *data)
     data->longitude = 31.0 + ((rand() % 10000) / 10000.0f); // 31.000 to 31.999
 }
 
-int main()
+static void usage(const char *prog)
+{
+    fprintf(stderr, "Usage: %s [-n sensors [-r rate] [-p flat|burst|diurnal] [-d seconds] [-S seed]] "
+                    "[sensor_id [safety|normal|bulk]]\n"
+                    "  -n sensors  simulate this many sensors with IDs sensor_id, sensor_id+1, ... (sensor_id required)\n"
+                    "  -r rate     aggregate samples per second (default: 1 per sensor)\n"
+                    "  -p profile  rate profile: flat, burst or diurnal (default flat)\n"
+                    "  -d seconds  stop after this many seconds (default 0 = run forever)\n"
+                    "  -S seed     PRNG seed (default: current time)\n",
+            prog);
+}
+
+int main(int argc, char *argv[])
 {
     int coid;
     message_t msg;
     sensor_data_t data;
     srand(time(NULL));
     int timeout = 0;
+    int opt;
+
+    // Simulator mode options; sim.sensors stays 0 for a single sensor sending every 1 second
+    sim_config_t sim;
+    memset(&sim, 0, sizeof(sim));
+    sim.profile = SIM_PROFILE_FLAT;
+    sim.seed = (uint64_t)time(NULL);
+
+    while ((opt = getopt(argc, argv, "n:r:p:d:S:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'n': sim.sensors = (uint32_t)strtoul(optarg, NULL, 0); break;
+        case 'r': sim.rate = strtod(optarg, NULL); break;
+        case 'p':
+            if (sim_parse_profile(optarg, &sim.profile) != 0)
+            {
+                usage(argv[0]);
+                exit(EXIT_FAILURE);
+            }
+            break;
+        case 'd': sim.duration = strtod(optarg, NULL); break;
+        case 'S': sim.seed = strtoull(optarg, NULL, 0); break;
+        default: usage(argv[0]); exit(EXIT_FAILURE);
+        }
+    }
+    // A simulator's IDs must be chosen explicitly: consecutive ranges from two PIDs would overlap
+    if (sim.rate < 0 || sim.duration < 0 || argc - optind > 2 || (sim.sensors > 0 && argc == optind))
+    {
+        usage(argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    if (sim.sensors > 0 && sim.rate == 0)
+        sim.rate = sim.sensors;
+
+    // Sensor ID from the command line, or the process ID so several simulators stay distinct
+    uint32_t sensor_id = (argc > optind) ? (uint32_t)strtoul(argv[optind], NULL, 0) : (uint32_t)getpid();
+
+    // Optional sensor class (safety, normal or bulk); without one the server follows our priority
+    uint8_t sensor_class = SENSOR_CLASS_DEFAULT;
+    if (argc > optind + 1)
+    {
+        if (strcmp(argv[optind + 1], "safety") == 0)
+            sensor_class = SENSOR_CLASS_SAFETY;
+        else if (strcmp(argv[optind + 1], "normal") == 0)
+            sensor_class = SENSOR_CLASS_NORMAL;
+        else if (strcmp(argv[optind + 1], "bulk") == 0)
+            sensor_class = SENSOR_CLASS_BULK;
+        else
+        {
+            usage(argv[0]);
+            exit(EXIT_FAILURE);
+        }
+    }
 
     // Attempt to connect to the server using name_open
     // The server should be running and registered with the name SENSOR_NAME
@@ -59,13 +133,30 @@ int main()
     // Successfully connected to the server
     printf("Connected to sensor server with coid: %d\n", coid);
 
+    if (sim.sensors > 0)
+    {
+        sim.first_id = sensor_id;
+        sim.sensor_class = sensor_class;
+        int ret = sim_run(coid, &sim);
+        name_close(coid);
+        return ret == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
     // Start generating and sending sensor data
-    printf("Sensor simulator started. Sending data every 1s...\n");
+    printf("Sensor simulator %u started. Sending data every 1s...\n", sensor_id);
 
+    uint32_t seq = 0;
     while (1)
     {
+        struct timespec now;
+        clock_gettime(CLOCK_REALTIME, &now);
+
         generate_sensor_data(&data);
         msg.type = SENSOR_MSG_TYPE;
+        msg.sensor_class = sensor_class;
+        msg.sensor_id = sensor_id;
+        msg.seq = seq++;
+        msg.timestamp_us = (uint64_t)now.tv_sec * 1000000ull + now.tv_nsec / 1000;
         msg.data = data;
 
         if (MsgSend(coid, &msg, sizeof(msg), NULL, 0) == -1)
@@ -10,6 +10,12 @@
  #define SENSOR_NAME "sensor"
  #define SENSOR_MSG_TYPE (_IO_MAX + 100)
 
+// Sensor classes, select the uplink lane in the sensor server
+#define SENSOR_CLASS_DEFAULT 0 // No class configured, the lane follows the client's priority
+#define SENSOR_CLASS_SAFETY 1  // Safety-relevant readings (e.g. speed), sent immediately
+#define SENSOR_CLASS_NORMAL 2  // Regular readings
+#define SENSOR_CLASS_BULK 3    // Bulk telemetry, coalesced
+
 typedef struct {
     float temperature; // in °C
     float speed;       // in km/h
@@ -19,7 +25,19 @@ typedef struct {
 
 typedef struct {
     uint16_t type;
+    uint8_t sensor_class; // SENSOR_CLASS_*
+    uint32_t sensor_id;  // Identifies the sensor, used to shard the uplink
+    uint32_t seq;        // Per-sensor sample sequence number, starts at 0 and wraps
+    uint64_t timestamp_us; // Sampling time, microseconds since the epoch
     sensor_data_t data;
 } message_t;
 
+// Plaintext of one frame sent to the TCP receiver, which reorders samples per sensor by seq
+typedef struct {
+    uint32_t sensor_id;
+    uint32_t seq;
+    uint64_t timestamp_us;
+    sensor_data_t data;
+} sensor_record_t;
+
 #endif // SENSOR_DEF_H
\ No newline at end of file
@@ -6,6 +6,10 @@
  *  It receives structured sensor data, encrypts it using AES-128-CBC, 
  *  and generates a CMAC for integrity verification.
  *  The encrypted data along with the CMAC is then sent over TCP to a remote server.
+ *  Samples are sharded by sensor ID across one or more TCP receivers (see uplink.h), given as
+ *  ip:port arguments or UPLINK_ENDPOINTS in tcp_conf.h, with failover to a standby receiver.
+ *  Frames wait on per-class priority lanes (see lanes.h): urgent readings are sent at once,
+ *  bulk telemetry is coalesced into batches sent over a single connection per receiver.
  * * @note
  *  The server uses the QNX message passing API to receive structured sensor data defined in sensor_def.h.
  *  It uses OpenSSL for AES encryption and CMAC generation. 
@@ -14,6 +18,8 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
+#include <time.h>
 #include <unistd.h>
 #include <sys/neutrino.h>
 #include <sys/netmgr.h>
@@ -29,6 +35,9 @@
 #include "sensor_def.h"
 #include "tcp_conf.h"
 #include "aes_key.h"
+#include "frame_pool.h"
+#include "uplink.h"
+#include "lanes.h"
 
 /* Function to generate CMAC for the given data
 key: The AES key used for CMAC generation    
@@ -44,25 +53,32 @@ int generate_cmac(const unsigned char *key,
         return -1; // Invalid parameters
     }
 
-    CMAC_CTX *ctx = CMAC_CTX_new();          
-    if (!ctx) return -1;
-    
-    if (!CMAC_Init(ctx, key, 16, EVP_aes_128_cbc(), NULL)) {
-        CMAC_CTX_free(ctx);
+    // The context is created once; while the key is unchanged it is only restarted per sample
+    static CMAC_CTX *ctx = NULL;
+    static const unsigned char *ctx_key = NULL;
+    if (!ctx) {
+        ctx = CMAC_CTX_new();
+        if (!ctx) return -1;
+    }
+
+    if (key != ctx_key) {
+        ctx_key = NULL;
+        if (!CMAC_Init(ctx, key, 16, EVP_aes_128_cbc(), NULL)) {
+            return -1;
+        }
+        ctx_key = key;
+    } else if (!CMAC_Init(ctx, NULL, 0, NULL, NULL)) {
         return -1;
     }
 
     if (!CMAC_Update(ctx, data, data_len)) {
-        CMAC_CTX_free(ctx);
         return -1;
     }
 
     if (!CMAC_Final(ctx, cmac_output, cmac_len)) {
-        CMAC_CTX_free(ctx);
         return -1;
     }
 
-    CMAC_CTX_free(ctx);
     return 0;
 }
 
@@ -78,65 +94,72 @@ int generate_cmac(const unsigned char *key,
  *  Returns: Length of the encrypted ciphertext
  *           -1 on error 
  */
-int aes_encrypt(unsigned char *plaintext, int plaintext_len,
+int aes_encrypt(const unsigned char *plaintext, int plaintext_len,
                 unsigned char *key, unsigned char *iv,
                 unsigned char *ciphertext)
 {
-    EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
+    // The context is created once and reused for every sample to keep the send path allocation free
+    static EVP_CIPHER_CTX *ctx = NULL;
     int len = 0, ciphertext_len = 0;
 
-    EVP_EncryptInit_ex(ctx, EVP_aes_128_cbc(), NULL, key, iv);
-    EVP_EncryptUpdate(ctx, ciphertext, &len, plaintext, plaintext_len);
+    if (ctx == NULL)
+    {
+        ctx = EVP_CIPHER_CTX_new();
+        if (ctx == NULL || !EVP_EncryptInit_ex(ctx, EVP_aes_128_cbc(), NULL, NULL, NULL))
+        {
+            EVP_CIPHER_CTX_free(ctx);
+            ctx = NULL;
+            return -1;
+        }
+    }
+
+    if (!EVP_EncryptInit_ex(ctx, NULL, NULL, key, iv))
+        return -1;
+    if (!EVP_EncryptUpdate(ctx, ciphertext, &len, plaintext, plaintext_len))
+        return -1;
     ciphertext_len = len;
 
-    EVP_EncryptFinal_ex(ctx, ciphertext + len, &len);
+    if (!EVP_EncryptFinal_ex(ctx, ciphertext + len, &len))
+        return -1;
     ciphertext_len += len;
 
-    EVP_CIPHER_CTX_free(ctx);
     return ciphertext_len;
 }
 
-// Encrypts sensor data and returns the length of the ciphertext, or -1 on error
-int encrypt_sensor_data(sensor_data_t *data, unsigned char **ciphertext, int *ciphertext_len)
+/* Encrypts a sensor record into a pool frame laid out as ciphertext followed by its CMAC.
+ * frame: Receives the frame on success; ownership passes to the caller, release with frame_free()
+ * Returns 0 on success, -1 on error */
+int encrypt_sensor_data(const sensor_record_t *record, frame_t **frame)
 {
-    int plaintext_len = sizeof(sensor_data_t);
-    unsigned char *plaintext = (unsigned char *)calloc(plaintext_len, sizeof(unsigned char));
-    if (!plaintext)
-    {
-        perror("calloc failed for plaintext");
-        return -1;
-    }
-    memcpy(plaintext, data, plaintext_len);
+    int plaintext_len = sizeof(sensor_record_t);
+    int ciphertext_len = 0;
 
-    *ciphertext = (unsigned char *)malloc(plaintext_len + AES_BLOCK_SIZE);
-    if (!*ciphertext)
+    // Room for the padded ciphertext and the CMAC
+    *frame = frame_alloc(plaintext_len + AES_BLOCK_SIZE + AES_BLOCK_SIZE);
+    if (!*frame)
     {
-        perror("malloc failed for ciphertext");
-        free(plaintext);
+        fprintf(stderr, "Frame pool exhausted, dropping sample\n");
         return -1;
     }
-    memset(*ciphertext, 0, plaintext_len + AES_BLOCK_SIZE);
 
-    *ciphertext_len = aes_encrypt(plaintext, plaintext_len,
-                                  (unsigned char *)aes_key, (unsigned char *)aes_iv, *ciphertext);
+    ciphertext_len = aes_encrypt((const unsigned char *)record, plaintext_len,
+                                 (unsigned char *)aes_key, (unsigned char *)aes_iv, (*frame)->data);
 
-    free(plaintext);
-
-    if (*ciphertext_len <= 0)
+    if (ciphertext_len <= 0)
     {
-        free(*ciphertext);
-        *ciphertext = NULL;
+        frame_free(*frame);
+        *frame = NULL;
         return -1;
     }
 
-    // Generate CMAC for the ciphertext
-    unsigned char cmac[EVP_MAX_MD_SIZE];
+    // Generate CMAC for the ciphertext and append it right behind the ciphertext
+    unsigned char *cmac = (*frame)->data + ciphertext_len;
     size_t cmac_len = 0;
 
-    if (generate_cmac(aes_key, *ciphertext, *ciphertext_len, cmac, &cmac_len) != 0)
+    if (generate_cmac(aes_key, (*frame)->data, ciphertext_len, cmac, &cmac_len) != 0)
     {
-        free(*ciphertext);
-        *ciphertext = NULL;
+        frame_free(*frame);
+        *frame = NULL;
         fprintf(stderr, "CMAC generation failed\n");
         return -1;
     }
@@ -148,81 +171,58 @@ int encrypt_sensor_data(sensor_data_t *data, unsigned char **ciphertext, int *ci
     }   
     printf("]\n");
 
-    // Append CMAC to the end of the ciphertext
-    *ciphertext = (unsigned char *)realloc(*ciphertext, *ciphertext_len + cmac_len);
-    if (NULL == *ciphertext)
-    {
-        perror("realloc failed for (ciphertext + cmac)!");
-        free(*ciphertext);
-        return -1;
-    }
-
-    memcpy(*ciphertext + *ciphertext_len, cmac, cmac_len);
-    *ciphertext_len += cmac_len;
+    (*frame)->len = ciphertext_len + cmac_len;
 
     return 0;
 }
 
-// Sends data over TCP, returns 0 on success, -1 on error
-int send_over_tcp(unsigned char *sdata, int data_len)
+// Wrapper: Encrypts a sample with its sensor ID, sequence number and timestamp and queues it
+// on its priority lane for the uplink scheduler
+int encrypt_and_queue(int lane, const message_t *msg)
 {
-    int sockfd;
-    struct sockaddr_in server_addr;
-
-    sockfd = socket(AF_INET, SOCK_STREAM, 0);
-    if (sockfd == -1)
-    {
-        perror("socket");
-        return -1;
-    }
-
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_port = htons(TCP_PORT);
-    server_addr.sin_addr.s_addr = inet_addr(REMOTE_IP);
-
-    if (connect(sockfd, (struct sockaddr *)&server_addr, sizeof(server_addr)) == -1)
-    {
-        perror("connect");
-        close(sockfd);
-        return -1;
-    }
-
-    if (send(sockfd, sdata, data_len, 0) == -1)
-    {
-        perror("send");
-        close(sockfd);
-        return -1;
-    }
-
-    printf("Encrypted and sent %d bytes of data to TCP receiver\n", data_len);
+    frame_t *frame = NULL;
+    sensor_record_t record;
 
-    if (close(sockfd) == -1)
-    {
-        perror("close");
-        return -1;
-    }
-    return 0;
-}
+    record.sensor_id = msg->sensor_id;
+    record.seq = msg->seq;
+    record.timestamp_us = msg->timestamp_us;
+    record.data = msg->data;
 
-// Wrapper: Encrypts and sends sensor data over TCP
-int encrypt_and_send_over_tcp(sensor_data_t *data)
-{
-    unsigned char *ciphertext = NULL;
-    int ciphertext_len = 0;
-    int ret = encrypt_sensor_data(data, &ciphertext, &ciphertext_len);
+    int ret = encrypt_sensor_data(&record, &frame);
     if (ret != 0)
         return -1;
 
-    ret = send_over_tcp(ciphertext, ciphertext_len);
-    free(ciphertext);
-    return ret;
+    // The lane owns the frame from here on
+    return lane_enqueue(lane, msg->sensor_id, frame);
 }
 
-int main()
+int main(int argc, char *argv[])
 {
     name_attach_t *attach;
     message_t msg;
+    struct _msg_info info;
     int rcvid;
+    uint64_t next_flush_ns = 0;
+    uint64_t next_stats_ns = 0;
+    static const char *const default_endpoints[] = UPLINK_ENDPOINTS;
+
+    // Receivers to shard across: ip:port arguments, or UPLINK_ENDPOINTS from tcp_conf.h
+    if (argc > 1)
+    {
+        if (uplink_init((const char *const *)&argv[1], argc - 1) != 0)
+            exit(EXIT_FAILURE);
+    }
+    else if (uplink_init(default_endpoints, sizeof(default_endpoints) / sizeof(default_endpoints[0])) != 0)
+    {
+        exit(EXIT_FAILURE);
+    }
+
+    // Preallocate all ciphertext frames
+    if (frame_pool_init() != 0)
+    {
+        fprintf(stderr, "Failed to initialize frame pool\n");
+        exit(EXIT_FAILURE);
+    }
 
     attach = name_attach(NULL, SENSOR_NAME, 0);
     if (attach == NULL)
@@ -232,45 +232,59 @@ int main()
     }
 
     printf("Sensor server started. Waiting for messages...\n");
+    next_stats_ns = lanes_now_ns() + LANE_STATS_INTERVAL_MS * 1000000ull;
 
     while (1)
     {
-        rcvid = MsgReceive(attach->chid, &msg, sizeof(msg), NULL);
+        // Wake up for the next lane flush deadline or stats print even if no message arrives,
+        // so an idle server still reports
+        uint64_t deadline = next_flush_ns != 0 && next_flush_ns < next_stats_ns ? next_flush_ns : next_stats_ns;
+        uint64_t now = lanes_now_ns();
+        uint64_t timeout = deadline > now ? deadline - now : 1;
+        TimerTimeout(CLOCK_MONOTONIC, _NTO_TIMEOUT_RECEIVE, NULL, &timeout, NULL);
+
+        rcvid = MsgReceive(attach->chid, &msg, sizeof(msg), &info);
         if (rcvid == -1)
         {
-            perror("MsgReceive failed");
-            continue;
+            if (errno != ETIMEDOUT)
+                perror("MsgReceive failed");
         }
-
-        if (rcvid == 0)
+        else if (rcvid == 0)
         {
             // PULSE, ignore
-            continue;
         }
-
-        if (msg.type == SENSOR_MSG_TYPE)
+        else if (msg.type == SENSOR_MSG_TYPE)
         {
+            int lane = lane_classify(info.priority, msg.sensor_class);
+
             // Print received sensor data
-            printf("Sensor data: Temp=%.1f°C, Speed=%.1fkm/h, GPS=(%.4f, %.4f)\n",
-                   msg.data.temperature, msg.data.speed,
+            printf("Sensor %u seq %u data (prio %d, lane %d): Temp=%.1f°C, Speed=%.1fkm/h, GPS=(%.4f, %.4f)\n",
+                   msg.sensor_id, msg.seq, info.priority, lane, msg.data.temperature, msg.data.speed,
                    msg.data.latitude, msg.data.longitude);
 
             // Send acknowledgment back to sender
             MsgReply(rcvid, 0, NULL, 0);
 
-            // Forward to TCP server
-            // if (send_over_tcp((unsigned char*)(&msg.data),sizeof(msg.data)) != 0)    /*send raw data*/
-            if (encrypt_and_send_over_tcp(&msg.data) != 0)  /*encrypt and send*/
+            // Queue for the TCP server
+            if (encrypt_and_queue(lane, &msg) != 0)  /*encrypt and queue*/
             {
-                fprintf(stderr, "Failed to send data over TCP\n");
+                fprintf(stderr, "Failed to queue data for TCP\n");
             }
-            puts("------------------------------------------------------------------------------------");
-
         }
         else
         {
             /*unknown message, ignore*/
-            continue;
+        }
+
+        // Uplink scheduler: urgent frames go out now, other lanes when a batch fills or its deadline passes
+        next_flush_ns = lanes_flush_due();
+
+        if (lanes_now_ns() >= next_stats_ns)
+        {
+            lanes_print_stats();
+            uplink_print_stats();
+            puts("------------------------------------------------------------------------------------");
+            next_stats_ns += LANE_STATS_INTERVAL_MS * 1000000ull;
         }
     }
 
@@ -0,0 +1,336 @@
+/**
+ * @file sensor_sim.c
+ * @brief Multi-sensor load simulator, see sensor_sim.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <math.h>
+#include <time.h>
+#include <sys/neutrino.h>
+
+#include "sensor_def.h"
+#include "sensor_sim.h"
+
+#define PRNG_LANES 8     // Interleaved generators, one per vector lane
+#define SIM_CHUNK 1024   // Sensors updated per vectorized step (multiple of PRNG_LANES)
+#define SIM_RANDOMS 3    // Uniform numbers drawn per sample: turn, acceleration, temperature noise
+#define SIM_MAX_LAG_NS 1000000000ull // Further behind schedule than this, the backlog is skipped
+
+// Trajectory model
+#define M_PER_DEG_LAT 111320.0f      // Metres per degree of latitude
+#define SIM_TURN_RAD 0.05f           // Heading random walk, radians per sqrt(second)
+#define SIM_SPEED_NOISE 3.0f         // Speed random walk, km/h per sqrt(second)
+#define SIM_SPEED_TAU 30.0f          // Seconds for speed to settle back to cruise speed
+#define SIM_SPEED_MAX 200.0f         // km/h
+#define SIM_TEMP_NOISE 0.2f          // Temperature random walk, °C per sqrt(second)
+#define SIM_TEMP_TAU 120.0f          // Seconds for temperature to settle back to its baseline
+#define SIM_TEMP_PER_KMH 0.05f       // Engine heating above baseline per km/h
+
+// 8-way xoshiro128+; state is stored word-major so each step is one vector operation per word
+typedef struct
+{
+    uint32_t s0[PRNG_LANES];
+    uint32_t s1[PRNG_LANES];
+    uint32_t s2[PRNG_LANES];
+    uint32_t s3[PRNG_LANES];
+} prng_t;
+
+// Virtual sensor state, one array per field so the update loop vectorizes
+typedef struct
+{
+    float *lat, *lon;        // Position, degrees
+    float *lon_m_per_deg;    // Metres per degree of longitude at the start position
+    float *hx, *hy;          // Heading as a unit vector (east, north)
+    float *speed, *cruise;   // km/h
+    float *temp, *temp_base; // °C
+    double *last_t;          // Time of the last sample, seconds since start (double: runs last for days)
+    uint32_t *seq;           // Sequence number of the next sample
+} sim_state_t;
+
+static uint64_t splitmix64(uint64_t *x)
+{
+    uint64_t z = (*x += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+static void prng_seed(prng_t *p, uint64_t seed)
+{
+    for (int l = 0; l < PRNG_LANES; l++)
+    {
+        uint64_t a = splitmix64(&seed);
+        uint64_t b = splitmix64(&seed);
+        p->s0[l] = (uint32_t)a;
+        p->s1[l] = (uint32_t)(a >> 32);
+        p->s2[l] = (uint32_t)b;
+        p->s3[l] = (uint32_t)(b >> 32) | 1; // Never all-zero
+    }
+}
+
+// Fill out[0..n) with uniform floats in [0, 1); n must be a multiple of PRNG_LANES
+static void prng_uniform(prng_t *restrict p, float *restrict out, size_t n)
+{
+    for (size_t i = 0; i < n; i += PRNG_LANES)
+    {
+        for (int l = 0; l < PRNG_LANES; l++)
+        {
+            uint32_t r = p->s0[l] + p->s3[l];
+            uint32_t t = p->s1[l] << 9;
+            p->s2[l] ^= p->s0[l];
+            p->s3[l] ^= p->s1[l];
+            p->s1[l] ^= p->s2[l];
+            p->s0[l] ^= p->s3[l];
+            p->s2[l] ^= t;
+            p->s3[l] = (p->s3[l] << 11) | (p->s3[l] >> 21);
+            out[i + l] = (float)(r >> 8) * (1.0f / 16777216.0f);
+        }
+    }
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+static int sim_alloc(sim_state_t *st, uint32_t n)
+{
+    float **fields[] = {&st->lat, &st->lon, &st->lon_m_per_deg, &st->hx, &st->hy,
+                        &st->speed, &st->cruise, &st->temp, &st->temp_base};
+    memset(st, 0, sizeof(*st));
+    for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++)
+    {
+        *fields[i] = (float *)calloc(n, sizeof(float));
+        if (*fields[i] == NULL)
+            return -1;
+    }
+    st->last_t = (double *)calloc(n, sizeof(double));
+    st->seq = (uint32_t *)calloc(n, sizeof(uint32_t));
+    return st->last_t && st->seq ? 0 : -1;
+}
+
+static void sim_free(sim_state_t *st)
+{
+    float *fields[] = {st->lat, st->lon, st->lon_m_per_deg, st->hx, st->hy,
+                       st->speed, st->cruise, st->temp, st->temp_base};
+    for (size_t i = 0; i < sizeof(fields) / sizeof(fields[0]); i++)
+        free(fields[i]);
+    free(st->last_t);
+    free(st->seq);
+}
+
+// Scatter the sensors over the same area as the single-sensor client, each with its own vehicle
+static void sim_init_sensors(sim_state_t *st, prng_t *p, uint32_t n)
+{
+    float u[8];
+    for (uint32_t i = 0; i < n; i++)
+    {
+        prng_uniform(p, u, 8);
+        float angle = u[2] * 6.2831853f;
+        st->lat[i] = 30.0f + u[0];
+        st->lon[i] = 31.0f + u[1];
+        st->lon_m_per_deg[i] = M_PER_DEG_LAT * cosf(st->lat[i] * 0.017453293f);
+        st->hx[i] = cosf(angle);
+        st->hy[i] = sinf(angle);
+        st->cruise[i] = 30.0f + u[3] * 100.0f; // 30 to 130 km/h
+        st->speed[i] = st->cruise[i] * u[4];
+        st->temp_base[i] = 20.0f + u[5] * 25.0f; // 20 to 45 °C
+        st->temp[i] = st->temp_base[i];
+        st->last_t[i] = 0.0;
+    }
+}
+
+// Advance sensors [first, first + n) to time t and write their samples to out[0..n)
+static void sim_step(sim_state_t *restrict st, const float *restrict rnd, uint32_t first, uint32_t n,
+                     double t, sensor_data_t *restrict out)
+{
+    float *restrict lat = st->lat + first, *restrict lon = st->lon + first;
+    float *restrict hx = st->hx + first, *restrict hy = st->hy + first;
+    float *restrict speed = st->speed + first, *restrict temp = st->temp + first;
+    double *restrict last_t = st->last_t + first;
+    const float *restrict cruise = st->cruise + first, *restrict temp_base = st->temp_base + first;
+    const float *restrict lon_m = st->lon_m_per_deg + first;
+
+    for (uint32_t k = 0; k < n; k++)
+    {
+        float dt = (float)(t - last_t[k]);
+        float sdt = sqrtf(dt);
+        float u_turn = rnd[k], u_acc = rnd[n + k], u_temp = rnd[2 * n + k];
+        last_t[k] = t;
+
+        // Heading: small random rotation of the unit vector, renormalized
+        float a = (2.0f * u_turn - 1.0f) * SIM_TURN_RAD * sdt;
+        float nx = hx[k] - a * hy[k];
+        float ny = hy[k] + a * hx[k];
+        float inv = 1.0f / sqrtf(nx * nx + ny * ny);
+        hx[k] = nx * inv;
+        hy[k] = ny * inv;
+
+        // Speed: mean-reverting toward the cruise speed
+        float pull = fminf(dt / SIM_SPEED_TAU, 1.0f);
+        float v = speed[k] + (cruise[k] - speed[k]) * pull + (2.0f * u_acc - 1.0f) * SIM_SPEED_NOISE * sdt;
+        v = fminf(fmaxf(v, 0.0f), SIM_SPEED_MAX);
+        speed[k] = v;
+
+        // Position: move by the distance travelled since the last sample
+        float d = v * (1.0f / 3.6f) * dt;
+        lat[k] += hy[k] * d * (1.0f / M_PER_DEG_LAT);
+        lon[k] += hx[k] * d / lon_m[k];
+
+        // Temperature: baseline plus engine heat, mean-reverting with noise
+        float target = temp_base[k] + v * SIM_TEMP_PER_KMH;
+        temp[k] += (target - temp[k]) * fminf(dt / SIM_TEMP_TAU, 1.0f) + (2.0f * u_temp - 1.0f) * SIM_TEMP_NOISE * sdt;
+
+        out[k].temperature = temp[k];
+        out[k].speed = v;
+        out[k].latitude = lat[k];
+        out[k].longitude = lon[k];
+    }
+}
+
+// Aggregate rate at time t seconds after start
+static double sim_rate(const sim_config_t *cfg, double t)
+{
+    switch (cfg->profile)
+    {
+    case SIM_PROFILE_BURST:
+        return fmod(t * 1000.0, SIM_BURST_PERIOD_MS) < SIM_BURST_MS ? cfg->rate * SIM_BURST_FACTOR : cfg->rate;
+    case SIM_PROFILE_DIURNAL:
+        // Night minimum at the start of each period, peak half way through
+        return cfg->rate * (SIM_DIURNAL_MIN + (1.0 - SIM_DIURNAL_MIN) * 0.5 *
+                            (1.0 - cos(2.0 * M_PI * t / SIM_DIURNAL_PERIOD_S)));
+    case SIM_PROFILE_FLAT:
+    default:
+        return cfg->rate;
+    }
+}
+
+int sim_parse_profile(const char *name, sim_profile_t *profile)
+{
+    if (strcmp(name, "flat") == 0)
+        *profile = SIM_PROFILE_FLAT;
+    else if (strcmp(name, "burst") == 0)
+        *profile = SIM_PROFILE_BURST;
+    else if (strcmp(name, "diurnal") == 0)
+        *profile = SIM_PROFILE_DIURNAL;
+    else
+        return -1;
+    return 0;
+}
+
+int sim_run(int coid, const sim_config_t *cfg)
+{
+    static float rnd[SIM_RANDOMS * SIM_CHUNK];
+    static sensor_data_t samples[SIM_CHUNK];
+    sim_state_t st;
+    prng_t prng;
+    message_t msg;
+    uint32_t cursor = 0;    // Next sensor to sample, sensors are sampled round robin
+    double carry = 0.0;     // Fraction of a sample owed from previous ticks
+    unsigned long sent = 0, errors = 0, skipped = 0;
+    double target = 0.0;    // Samples the profile asked for since the last report
+    uint64_t max_lag_ns = 0;
+
+    if (cfg->sensors == 0 || cfg->rate <= 0)
+    {
+        fprintf(stderr, "Simulator needs at least one sensor and a positive rate\n");
+        return -1;
+    }
+    if (sim_alloc(&st, cfg->sensors) != 0)
+    {
+        perror("calloc failed for simulator state");
+        sim_free(&st);
+        return -1;
+    }
+
+    prng_seed(&prng, cfg->seed);
+    sim_init_sensors(&st, &prng, cfg->sensors);
+
+    memset(&msg, 0, sizeof(msg));
+    msg.type = SENSOR_MSG_TYPE;
+    msg.sensor_class = cfg->sensor_class;
+
+    uint64_t start = now_ns();
+    struct timespec wall;
+    clock_gettime(CLOCK_REALTIME, &wall);
+    uint64_t start_us = (uint64_t)wall.tv_sec * 1000000ull + wall.tv_nsec / 1000;  // Sample timestamps follow the paced schedule
+    uint64_t deadline = start + SIM_TICK_NS;
+    uint64_t next_report = start + 1000000000ull;
+    uint64_t end = cfg->duration > 0 ? start + (uint64_t)(cfg->duration * 1e9) : 0;
+
+    while (end == 0 || deadline <= end)
+    {
+        // Sleep to an absolute deadline: time spent sending never accumulates as drift
+        struct timespec due = {(time_t)(deadline / 1000000000ull), (long)(deadline % 1000000000ull)};
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &due, NULL) == EINTR)
+            ;
+
+        uint64_t now = now_ns();
+        if (now > deadline && now - deadline > max_lag_ns)
+            max_lag_ns = now - deadline;
+        if (now > deadline + SIM_MAX_LAG_NS)
+        {
+            // Too far behind to catch up: drop the backlog instead of bursting it out
+            uint64_t behind = (now - deadline) / SIM_TICK_NS * SIM_TICK_NS;
+            skipped += (unsigned long)(sim_rate(cfg, (deadline - start) / 1e9) * behind / 1e9);
+            deadline += behind;
+        }
+
+        double t = (deadline - start) / 1e9;
+        double owed = sim_rate(cfg, t) * (SIM_TICK_NS / 1e9);
+        target += owed;
+        carry += owed;
+        uint64_t due_samples = (uint64_t)carry;
+        carry -= (double)due_samples;
+
+        while (due_samples > 0)
+        {
+            uint32_t n = cfg->sensors - cursor;
+            if (n > SIM_CHUNK)
+                n = SIM_CHUNK;
+            if (n > due_samples)
+                n = (uint32_t)due_samples;
+
+            // Random numbers for the whole chunk first, then one vectorizable pass over the sensors
+            prng_uniform(&prng, rnd, (SIM_RANDOMS * n + PRNG_LANES - 1) / PRNG_LANES * PRNG_LANES);
+            sim_step(&st, rnd, cursor, n, t, samples);
+
+            for (uint32_t k = 0; k < n; k++)
+            {
+                msg.sensor_id = cfg->first_id + cursor + k;
+                msg.seq = st.seq[cursor + k]++;
+                msg.timestamp_us = start_us + (deadline - start) / 1000;
+                msg.data = samples[k];
+                if (MsgSend(coid, &msg, sizeof(msg), NULL, 0) == -1)
+                    errors++;
+                else
+                    sent++;
+            }
+
+            cursor = (cursor + n) % cfg->sensors;
+            due_samples -= n;
+        }
+
+        deadline += SIM_TICK_NS;
+
+        if (now >= next_report)
+        {
+            printf("Simulator: %lu samples/s (target %.0f/s), %lu send errors, %lu skipped, max lag %.2f ms\n",
+                   sent, target, errors, skipped, max_lag_ns / 1e6);
+            sent = 0;
+            target = 0.0;
+            errors = 0;
+            skipped = 0;
+            max_lag_ns = 0;
+            next_report += 1000000000ull;
+        }
+    }
+
+    sim_free(&st);
+    return 0;
+}
@@ -0,0 +1,55 @@
+/**
+ * @file sensor_sim.h
+ * @brief Multi-sensor load simulator used by sensor_client's simulator mode.
+ * @details
+ *  Drives many virtual sensors from one process. Each sensor follows a random-walk trajectory:
+ *  a vehicle holding a heading and a mean-reverting cruise speed, moving its GPS position by the
+ *  distance actually travelled, with an engine temperature drifting around its own baseline.
+ *  Randomness comes from an 8-way interleaved xoshiro128+ generator whose state is laid out so
+ *  the update loops vectorize. Samples are paced against absolute CLOCK_MONOTONIC deadlines, so
+ *  the aggregate rate does not drift, and can follow a flat, bursty or diurnal profile.
+ */
+
+#ifndef SENSOR_SIM_H
+#define SENSOR_SIM_H
+
+#include <stdint.h>
+
+#define SIM_TICK_NS 1000000ull         // Pacing granularity: samples due in each 1 ms tick are sent together
+#define SIM_BURST_FACTOR 5.0           // Burst profile: rate multiplier during a burst
+#define SIM_BURST_MS 1000              // Burst profile: burst length
+#define SIM_BURST_PERIOD_MS 10000      // Burst profile: one burst per period
+#define SIM_DIURNAL_PERIOD_S 600       // Diurnal profile: length of one compressed day
+#define SIM_DIURNAL_MIN 0.1            // Diurnal profile: night-time rate as a fraction of the peak
+
+typedef enum
+{
+    SIM_PROFILE_FLAT,    // Constant rate
+    SIM_PROFILE_BURST,   // Base rate with periodic bursts
+    SIM_PROFILE_DIURNAL  // Sinusoidal day/night cycle peaking at the configured rate
+} sim_profile_t;
+
+typedef struct
+{
+    uint32_t sensors;      // Number of virtual sensors
+    uint32_t first_id;     // Sensor ID of the first virtual sensor, the others follow consecutively
+    uint8_t sensor_class;  // SENSOR_CLASS_* sent with every sample
+    double rate;           // Aggregate samples per second (peak rate for the diurnal profile)
+    sim_profile_t profile;
+    double duration;       // Seconds to run, 0 = forever
+    uint64_t seed;         // PRNG seed, the same seed reproduces the same trajectories
+} sim_config_t;
+
+/*
+ * Run the simulator, sending every sample to the sensor server over coid.
+ * Returns: 0 when the configured duration has elapsed, -1 on setup failure
+ */
+int sim_run(int coid, const sim_config_t *cfg);
+
+/*
+ * Parse a profile name (flat, burst or diurnal).
+ * Returns: 0 on success, -1 on an unknown name
+ */
+int sim_parse_profile(const char *name, sim_profile_t *profile);
+
+#endif // SENSOR_SIM_H
@@ -9,4 +9,18 @@
 #define REMOTE_IP   "192.168.25.29"  // target TCP server IP
 #define TCP_PORT 8000
 
+#define TCP_CONF_STR_(x) #x
+#define TCP_CONF_STR(x) TCP_CONF_STR_(x)
+
+// Uplink receivers as "ip:port"; samples are sharded across them by sensor ID.
+// Overridden at run time by passing ip:port arguments to sensor_server.
+#define UPLINK_ENDPOINTS { REMOTE_IP ":" TCP_CONF_STR(TCP_PORT) }
+
+#define UPLINK_VNODES 256             // Hash ring points per endpoint, more gives a more even spread
+#define UPLINK_CONNECT_TIMEOUT_MS 200 // Give up on a receiver that does not accept within this time
+#define UPLINK_SEND_TIMEOUT_MS 200    // Give up on a receiver that does not take the frame within this time
+#define UPLINK_SLOW_MS 100            // Fail over when the average connect + send time exceeds this
+#define UPLINK_BACKOFF_MIN_MS 250     // First re-probe of a failed receiver
+#define UPLINK_BACKOFF_MAX_MS 8000    // Probe back-off cap
+
 #endif // TCP_CONF_H
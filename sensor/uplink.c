@@ -0,0 +1,393 @@
+/**
+ * @file uplink.c
+ * @brief Sharded, health-tracked uplink to the TCP receivers, see uplink.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+
+#include "tcp_conf.h"
+#include "uplink.h"
+
+#define UPLINK_RING_SIZE (UPLINK_MAX_ENDPOINTS * UPLINK_VNODES)
+
+typedef struct
+{
+    struct sockaddr_in addr;
+    char name[32];              // "ip:port", for logs
+    int up;                     // 0 while taken out of rotation
+    uint64_t retry_at_ns;       // When a down endpoint may be probed again
+    unsigned int backoff_ms;    // Current probe back-off
+    uint64_t latency_ns;        // Moving average of connect + send time
+    unsigned long sent;
+    unsigned long failed;
+} uplink_endpoint_t;
+
+typedef struct
+{
+    uint32_t hash;
+    int endpoint;
+} uplink_vnode_t;
+
+static uplink_endpoint_t endpoints[UPLINK_MAX_ENDPOINTS];
+static int endpoint_count = 0;
+static uplink_vnode_t ring[UPLINK_RING_SIZE];
+static int ring_size = 0;
+static uint32_t jitter_state = 0x9E3779B9u;
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// FNV-1a over a virtual node's "ip:port#v" name, mixed further by hash_sensor() before use
+static uint32_t hash_string(const char *s)
+{
+    uint32_t h = 2166136261u;
+    while (*s)
+    {
+        h ^= (unsigned char)*s++;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// Murmur3 finalizer: spreads consecutive sensor IDs evenly over the ring. Also applied to the
+// vnode hashes, whose FNV values differ only by a multiple of the FNV prime for similar names.
+static uint32_t hash_sensor(uint32_t id)
+{
+    id ^= id >> 16;
+    id *= 0x85EBCA6Bu;
+    id ^= id >> 13;
+    id *= 0xC2B2AE35u;
+    id ^= id >> 16;
+    return id;
+}
+
+static int compare_vnodes(const void *a, const void *b)
+{
+    uint32_t ha = ((const uplink_vnode_t *)a)->hash;
+    uint32_t hb = ((const uplink_vnode_t *)b)->hash;
+    return (ha > hb) - (ha < hb);
+}
+
+int uplink_init(const char *const *names, int count)
+{
+    if (count < 1 || count > UPLINK_MAX_ENDPOINTS)
+    {
+        fprintf(stderr, "Uplink needs 1 to %d endpoints, got %d\n", UPLINK_MAX_ENDPOINTS, count);
+        return -1;
+    }
+
+    memset(endpoints, 0, sizeof(endpoints));
+    for (int i = 0; i < count; i++)
+    {
+        uplink_endpoint_t *ep = &endpoints[i];
+        char ip[INET_ADDRSTRLEN];
+        const char *colon = strrchr(names[i], ':');
+        int port = colon ? atoi(colon + 1) : 0;
+        size_t ip_len = colon ? (size_t)(colon - names[i]) : 0;
+
+        if (ip_len == 0 || ip_len >= sizeof(ip) || port <= 0 || port > 65535)
+        {
+            fprintf(stderr, "Invalid uplink endpoint \"%s\", expected ip:port\n", names[i]);
+            return -1;
+        }
+        memcpy(ip, names[i], ip_len);
+        ip[ip_len] = '\0';
+
+        ep->addr.sin_family = AF_INET;
+        ep->addr.sin_port = htons(port);
+        if (inet_pton(AF_INET, ip, &ep->addr.sin_addr) != 1)
+        {
+            fprintf(stderr, "Invalid uplink address \"%s\"\n", ip);
+            return -1;
+        }
+        snprintf(ep->name, sizeof(ep->name), "%s:%d", ip, port);
+        ep->up = 1;
+        ep->backoff_ms = UPLINK_BACKOFF_MIN_MS;
+
+        for (int v = 0; v < UPLINK_VNODES; v++)
+        {
+            char vnode[sizeof(ep->name) + 8];
+            snprintf(vnode, sizeof(vnode), "%s#%d", ep->name, v);
+            ring[i * UPLINK_VNODES + v].hash = hash_sensor(hash_string(vnode));
+            ring[i * UPLINK_VNODES + v].endpoint = i;
+        }
+    }
+    endpoint_count = count;
+    ring_size = count * UPLINK_VNODES;
+    qsort(ring, ring_size, sizeof(ring[0]), compare_vnodes);
+    jitter_state ^= (uint32_t)now_ns();
+
+    for (int i = 0; i < count; i++)
+        printf("Uplink endpoint %d: %s\n", i, endpoints[i].name);
+    return 0;
+}
+
+// Take an endpoint out of rotation until its jittered back-off has passed
+static void mark_down(uplink_endpoint_t *ep, uint64_t now, const char *reason)
+{
+    // xorshift32: +-25% jitter keeps probes from several servers from lining up
+    jitter_state ^= jitter_state << 13;
+    jitter_state ^= jitter_state >> 17;
+    jitter_state ^= jitter_state << 5;
+    unsigned int delay_ms = ep->backoff_ms - ep->backoff_ms / 4 + jitter_state % (ep->backoff_ms / 2 + 1);
+
+    if (ep->up)
+        fprintf(stderr, "Uplink %s down (%s), failing over; next probe in %u ms\n", ep->name, reason, delay_ms);
+    ep->up = 0;
+    ep->retry_at_ns = now + (uint64_t)delay_ms * 1000000ull;
+    ep->backoff_ms = ep->backoff_ms * 2 > UPLINK_BACKOFF_MAX_MS ? UPLINK_BACKOFF_MAX_MS : ep->backoff_ms * 2;
+}
+
+// Connect with a bounded timeout and send the frames back to back, returns 0 on success, -1 on error
+static int send_to_endpoint(const uplink_endpoint_t *ep, const struct iovec *iov, int iov_count, size_t len)
+{
+    struct pollfd pfd;
+    int err = 0;
+    socklen_t err_len = sizeof(err);
+    struct timeval send_timeout = {0, UPLINK_SEND_TIMEOUT_MS * 1000};
+
+    int sockfd = socket(AF_INET, SOCK_STREAM, 0);
+    if (sockfd == -1)
+    {
+        perror("socket");
+        return -1;
+    }
+
+    // Non-blocking connect so a dead receiver costs at most UPLINK_CONNECT_TIMEOUT_MS
+    fcntl(sockfd, F_SETFL, fcntl(sockfd, F_GETFL, 0) | O_NONBLOCK);
+    if (connect(sockfd, (const struct sockaddr *)&ep->addr, sizeof(ep->addr)) == -1)
+    {
+        if (errno != EINPROGRESS)
+        {
+            close(sockfd);
+            return -1;
+        }
+        pfd.fd = sockfd;
+        pfd.events = POLLOUT;
+        if (poll(&pfd, 1, UPLINK_CONNECT_TIMEOUT_MS) != 1 ||
+            getsockopt(sockfd, SOL_SOCKET, SO_ERROR, &err, &err_len) == -1 || err != 0)
+        {
+            close(sockfd);
+            return -1;
+        }
+    }
+    fcntl(sockfd, F_SETFL, fcntl(sockfd, F_GETFL, 0) & ~O_NONBLOCK);
+    setsockopt(sockfd, SOL_SOCKET, SO_SNDTIMEO, &send_timeout, sizeof(send_timeout));
+
+    // One gathered write for the whole batch; a short write counts as a failure
+    if (writev(sockfd, iov, iov_count) != (ssize_t)len)
+    {
+        close(sockfd);
+        return -1;
+    }
+
+    if (close(sockfd) == -1)
+    {
+        perror("close");
+        return -1;
+    }
+    return 0;
+}
+
+// Update endpoint health after frames were delivered in one connection started at start
+static void record_success(uplink_endpoint_t *ep, uint64_t start, int frames)
+{
+    uint64_t latency = now_ns() - start;
+    ep->sent += frames;
+
+    if (!ep->up)
+    {
+        // Successful probe: back in rotation, judged on fresh latency only
+        printf("Uplink %s recovered\n", ep->name);
+        ep->up = 1;
+        ep->backoff_ms = UPLINK_BACKOFF_MIN_MS;
+        ep->latency_ns = latency;
+    }
+    else
+    {
+        ep->latency_ns = ep->latency_ns ? (ep->latency_ns * 7 + latency) / 8 : latency;
+    }
+    if (ep->latency_ns > (uint64_t)UPLINK_SLOW_MS * 1000000ull)
+    {
+        // Delivered, but too slow to keep: shift its sensors to their standby
+        mark_down(ep, now_ns(), "slow");
+    }
+}
+
+// Index of the first vnode at or after the sensor's hash, wrapping around the ring
+static int ring_position(uint32_t sensor_id)
+{
+    uint32_t key = hash_sensor(sensor_id);
+    int lo = 0, hi = ring_size;
+
+    while (lo < hi)
+    {
+        int mid = (lo + hi) / 2;
+        if (ring[mid].hash < key)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo % ring_size;
+}
+
+/*
+ * First endpoint on the sensor's ring walk that is in rotation or due for a probe, -1 if none
+ * skip: Bit per endpoint to pass over, e.g. those that already failed for this batch
+ */
+static int route(uint32_t sensor_id, unsigned int skip)
+{
+    int pos = ring_position(sensor_id);
+    uint64_t now = now_ns();
+
+    for (int step = 0; step < ring_size; step++)
+    {
+        int idx = ring[(pos + step) % ring_size].endpoint;
+        if (skip & (1u << idx))
+            continue;
+        if (endpoints[idx].up || now >= endpoints[idx].retry_at_ns)
+            return idx;
+    }
+    return -1;
+}
+
+int uplink_send(uint32_t sensor_id, const unsigned char *data, size_t len)
+{
+    unsigned int tried = 0; // Bit per endpoint already attempted for this frame
+    int pos = ring_position(sensor_id);
+    struct iovec iov = {(void *)data, len};
+
+    // Only endpoints in rotation or due for a probe: a failed attempt pushes the endpoint's next
+    // probe out, so each down endpoint sees at most one connect per back-off period
+    for (int step = 0; step < ring_size; step++)
+    {
+        int idx = ring[(pos + step) % ring_size].endpoint;
+        uplink_endpoint_t *ep = &endpoints[idx];
+        uint64_t start = now_ns();
+
+        if (tried & (1u << idx))
+            continue;
+        if (!ep->up && start < ep->retry_at_ns)
+            continue;
+        tried |= 1u << idx;
+
+        if (send_to_endpoint(ep, &iov, 1, len) != 0)
+        {
+            ep->failed++;
+            mark_down(ep, now_ns(), "send failed");
+            continue;
+        }
+
+        printf("Encrypted and sent %zu bytes of data to TCP receiver %s (sensor %u)\n", len, ep->name, sensor_id);
+        record_success(ep, start, 1);
+        return 0;
+    }
+
+    fprintf(stderr, "No uplink endpoint available for sensor %u, dropping frame\n", sensor_id);
+    return -1;
+}
+
+#define UPLINK_FRAME_SENT (-2) // Batch slot already delivered
+
+int uplink_send_batch(const uplink_frame_t *frames, int count)
+{
+    signed char target[UPLINK_MAX_BATCH]; // Endpoint per frame, -1 if none is available
+    struct iovec iov[UPLINK_MAX_BATCH];
+    unsigned int failed = 0;              // Bit per endpoint that failed during this batch
+    int sent = 0;
+
+    if (count > UPLINK_MAX_BATCH)
+    {
+        // Split oversized batches rather than fail them, head first so each sensor keeps its order
+        for (int first = 0; first < count; first += UPLINK_MAX_BATCH)
+            sent += uplink_send_batch(frames + first, count - first < UPLINK_MAX_BATCH ? count - first : UPLINK_MAX_BATCH);
+        return sent;
+    }
+
+    for (int i = 0; i < count; i++)
+        target[i] = (signed char)route(frames[i].sensor_id, 0);
+
+    // One connection per receiver, carrying that receiver's frames in queue order. A receiver that
+    // fails is not tried again in this batch; its frames are routed to their standbys and join
+    // their connections, so failover costs one connection per standby, not one per frame.
+    for (;;)
+    {
+        int idx = -1;
+        int iov_count = 0;
+        size_t len = 0;
+
+        for (int i = 0; i < count && idx < 0; i++)
+        {
+            if (target[i] >= 0)
+                idx = target[i];
+        }
+        if (idx < 0)
+            break;
+
+        uplink_endpoint_t *ep = &endpoints[idx];
+        for (int i = 0; i < count; i++)
+        {
+            if (target[i] != idx)
+                continue;
+            iov[iov_count].iov_base = (void *)frames[i].data;
+            iov[iov_count].iov_len = frames[i].len;
+            len += frames[i].len;
+            iov_count++;
+        }
+
+        uint64_t start = now_ns();
+        if (send_to_endpoint(ep, iov, iov_count, len) == 0)
+        {
+            printf("Sent batch of %d frames (%zu bytes) to TCP receiver %s\n", iov_count, len, ep->name);
+            record_success(ep, start, iov_count);
+            sent += iov_count;
+            for (int i = 0; i < count; i++)
+            {
+                if (target[i] == idx)
+                    target[i] = UPLINK_FRAME_SENT;
+            }
+            continue;
+        }
+
+        // Fail the receiver over: its frames move to their standbys, grouped again by endpoint
+        ep->failed++;
+        mark_down(ep, now_ns(), "send failed");
+        failed |= 1u << idx;
+        for (int i = 0; i < count; i++)
+        {
+            if (target[i] == idx)
+                target[i] = (signed char)route(frames[i].sensor_id, failed);
+        }
+    }
+
+    // Frames whose whole ring is down and not yet due for a probe are dropped, not retried:
+    // hammering dead receivers would stall the scheduler and defeat the back-off
+    if (sent < count)
+        fprintf(stderr, "No uplink endpoint available, dropping %d frames\n", count - sent);
+    return sent;
+}
+
+void uplink_print_stats(void)
+{
+    for (int i = 0; i < endpoint_count; i++)
+    {
+        const uplink_endpoint_t *ep = &endpoints[i];
+        printf("Uplink %-21s %-4s latency=%.2fms sent=%lu failed=%lu\n", ep->name, ep->up ? "up" : "down",
+               ep->latency_ns / 1e6, ep->sent, ep->failed);
+    }
+}
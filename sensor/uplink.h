@@ -0,0 +1,60 @@
+/**
+ * @file uplink.h
+ * @brief Uplink to a set of TCP receivers with consistent-hash sharding and failover.
+ * @details
+ *  Every endpoint owns UPLINK_VNODES points on a hash ring. A sample goes to the first endpoint
+ *  at or after the hash of its sensor ID, so each sensor sticks to one receiver and adding or
+ *  losing a receiver only moves the sensors that hashed to it. Walking further along the ring
+ *  gives each sensor a stable standby.
+ *  Endpoints are tracked from send latency and errors: a failed or slow endpoint is taken out of
+ *  rotation at once and its sensors fail over to their standby; it is probed again after a
+ *  jittered, exponentially growing back-off, so a restarted receiver is not hit by a reconnect storm.
+ */
+
+#ifndef UPLINK_H
+#define UPLINK_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define UPLINK_MAX_ENDPOINTS 16
+#define UPLINK_MAX_BATCH 64 // Frames gathered into one send per receiver
+
+typedef struct
+{
+    uint32_t sensor_id;         // Shard key
+    const unsigned char *data;  // Encrypted frame
+    size_t len;
+} uplink_frame_t;
+
+/*
+ * Configure the receivers to send to.
+ * endpoints: "ip:port" strings
+ * count: Number of endpoints, 1..UPLINK_MAX_ENDPOINTS
+ * Returns: 0 on success, -1 on an invalid endpoint
+ */
+int uplink_init(const char *const *endpoints, int count);
+
+/*
+ * Send one frame to the receiver the sensor is sharded to, failing over along the ring
+ * until a receiver accepts it. Endpoints that are down are only tried once their back-off expires.
+ * Returns: 0 on success, -1 if no receiver could take the frame (the frame is dropped)
+ */
+int uplink_send(uint32_t sensor_id, const unsigned char *data, size_t len);
+
+/*
+ * Send a batch of frames, coalescing all frames that route to the same receiver into one
+ * connection. Frames of one sensor keep their order. When a receiver fails, its frames are
+ * routed to their standbys and coalesced again, one connection per standby; a failed receiver
+ * is not retried within the batch. Frames with no receiver in rotation or due for a probe
+ * are dropped.
+ * Returns: number of frames delivered
+ */
+int uplink_send_batch(const uplink_frame_t *frames, int count);
+
+/*
+ * Print per-endpoint health, latency and counters.
+ */
+void uplink_print_stats(void);
+
+#endif // UPLINK_H
@@ -0,0 +1,200 @@
+/**
+ * @file capture.c
+ * @brief Capture file writer and reader, see capture.h for the format.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "capture.h"
+
+#define CAPTURE_FLUSH_RECORDS 64     // Flush the stdio buffer after this many records
+#define CAPTURE_FLUSH_NS 1000000000ull // ... or when this much time has passed since the last flush
+#define CAPTURE_STDIO_BUFFER (64 * 1024)
+
+static void put_u16(unsigned char *p, uint16_t v)
+{
+    p[0] = (unsigned char)v;
+    p[1] = (unsigned char)(v >> 8);
+}
+
+static void put_u32(unsigned char *p, uint32_t v)
+{
+    put_u16(p, (uint16_t)v);
+    put_u16(p + 2, (uint16_t)(v >> 16));
+}
+
+static void put_u64(unsigned char *p, uint64_t v)
+{
+    put_u32(p, (uint32_t)v);
+    put_u32(p + 4, (uint32_t)(v >> 32));
+}
+
+static uint16_t get_u16(const unsigned char *p)
+{
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get_u32(const unsigned char *p)
+{
+    return get_u16(p) | ((uint32_t)get_u16(p + 2) << 16);
+}
+
+static uint64_t get_u64(const unsigned char *p)
+{
+    return get_u32(p) | ((uint64_t)get_u32(p + 4) << 32);
+}
+
+// Validate a file header read from the start of a capture
+static int check_header(const unsigned char *hdr)
+{
+    if (memcmp(hdr, CAPTURE_MAGIC, 8) != 0)
+    {
+        fprintf(stderr, "Not a capture file (bad magic)\n");
+        return -1;
+    }
+    if (get_u16(hdr + 8) != CAPTURE_VERSION || get_u16(hdr + 10) != CAPTURE_HEADER_SIZE)
+    {
+        fprintf(stderr, "Unsupported capture version %u, expected %u\n", get_u16(hdr + 8), CAPTURE_VERSION);
+        return -1;
+    }
+    return 0;
+}
+
+capture_t *capture_open(const char *path)
+{
+    unsigned char hdr[CAPTURE_HEADER_SIZE] = {0};
+    capture_t *cap = (capture_t *)calloc(1, sizeof(capture_t));
+    if (cap == NULL)
+    {
+        perror("calloc failed for capture");
+        return NULL;
+    }
+
+    cap->fp = fopen(path, "a+b");
+    if (cap->fp == NULL)
+    {
+        perror("fopen capture file");
+        free(cap);
+        return NULL;
+    }
+    setvbuf(cap->fp, NULL, _IOFBF, CAPTURE_STDIO_BUFFER);
+
+    // Existing capture: check it is ours before appending to it
+    size_t n = fread(hdr, 1, sizeof(hdr), cap->fp);
+    fseek(cap->fp, 0, SEEK_END); // Switch the stream from reading to appending
+    if (n != 0)
+    {
+        if (n != sizeof(hdr) || check_header(hdr) != 0)
+        {
+            fprintf(stderr, "Refusing to append to invalid capture file: %s\n", path);
+            fclose(cap->fp);
+            free(cap);
+            return NULL;
+        }
+        return cap;
+    }
+
+    // New (or empty) capture: write the file header
+    memcpy(hdr, CAPTURE_MAGIC, 8);
+    put_u16(hdr + 8, CAPTURE_VERSION);
+    put_u16(hdr + 10, CAPTURE_HEADER_SIZE);
+    if (fwrite(hdr, 1, sizeof(hdr), cap->fp) != sizeof(hdr) || fflush(cap->fp) != 0)
+    {
+        perror("write capture header");
+        fclose(cap->fp);
+        free(cap);
+        return NULL;
+    }
+    return cap;
+}
+
+int capture_write(capture_t *cap, uint32_t peer_addr, uint16_t peer_port,
+                  const unsigned char *frame, size_t len)
+{
+    unsigned char hdr[CAPTURE_RECORD_HEADER_SIZE];
+    struct timespec ts;
+
+    if (len > CAPTURE_MAX_FRAME)
+        return -1;
+
+    timespec_get(&ts, TIME_UTC);
+    uint64_t now_ns = (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+    put_u64(hdr, now_ns);
+    memcpy(hdr + 8, &peer_addr, 4);  // Already in network order
+    memcpy(hdr + 12, &peer_port, 2); // Already in network order
+    put_u16(hdr + 14, (uint16_t)len);
+
+    if (fwrite(hdr, 1, sizeof(hdr), cap->fp) != sizeof(hdr) ||
+        fwrite(frame, 1, len, cap->fp) != len)
+    {
+        perror("write capture record");
+        return -1;
+    }
+
+    if (++cap->records % CAPTURE_FLUSH_RECORDS == 0 || now_ns - cap->last_flush_ns >= CAPTURE_FLUSH_NS)
+    {
+        fflush(cap->fp);
+        cap->last_flush_ns = now_ns;
+    }
+    return 0;
+}
+
+void capture_flush(capture_t *cap)
+{
+    struct timespec ts;
+
+    if (cap == NULL)
+        return;
+    fflush(cap->fp);
+    timespec_get(&ts, TIME_UTC);
+    cap->last_flush_ns = (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+void capture_close(capture_t *cap)
+{
+    if (cap == NULL)
+        return;
+    fclose(cap->fp);
+    free(cap);
+}
+
+FILE *capture_open_read(const char *path)
+{
+    unsigned char hdr[CAPTURE_HEADER_SIZE];
+    FILE *fp = fopen(path, "rb");
+    if (fp == NULL)
+    {
+        perror("fopen capture file");
+        return NULL;
+    }
+
+    if (fread(hdr, 1, sizeof(hdr), fp) != sizeof(hdr) || check_header(hdr) != 0)
+    {
+        fprintf(stderr, "Invalid capture file: %s\n", path);
+        fclose(fp);
+        return NULL;
+    }
+    return fp;
+}
+
+int capture_read(FILE *fp, capture_record_t *rec, unsigned char *frame)
+{
+    unsigned char hdr[CAPTURE_RECORD_HEADER_SIZE];
+    size_t n = fread(hdr, 1, sizeof(hdr), fp);
+
+    if (n == 0 && feof(fp))
+        return 0;
+    if (n != sizeof(hdr))
+        return -1;
+
+    rec->timestamp_ns = get_u64(hdr);
+    memcpy(&rec->peer_addr, hdr + 8, 4);
+    memcpy(&rec->peer_port, hdr + 12, 2);
+    rec->len = get_u16(hdr + 14);
+
+    if (fread(frame, 1, rec->len, fp) != rec->len)
+        return -1;
+    return 1;
+}
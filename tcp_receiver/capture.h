@@ -0,0 +1,76 @@
+/**
+ * @file capture.h
+ * @brief Append-only capture of raw inbound frames for offline re-ingest and benchmarking.
+ * @details
+ *  File layout (all integers little-endian):
+ *    file header, 16 bytes:   magic "TRXCAP\0\0" (8), version (u16), header size (u16), reserved (u32)
+ *    record header, 16 bytes: arrival time in ns since the epoch (u64), peer IPv4 address (u32, network order),
+ *                             peer TCP port (u16, network order), frame length (u16)
+ *    frame bytes, exactly as received
+ *  Records are written in arrival order, so replaying them in file order is deterministic.
+ */
+
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define CAPTURE_MAGIC "TRXCAP\0\0"
+#define CAPTURE_VERSION 2 // 2: frames carry sensor_record_t (64 bytes); version 1 frames carried sensor_data_t (48 bytes)
+#define CAPTURE_HEADER_SIZE 16
+#define CAPTURE_RECORD_HEADER_SIZE 16
+#define CAPTURE_MAX_FRAME 0xFFFF // Largest frame a record can hold
+
+typedef struct
+{
+    uint64_t timestamp_ns; // Arrival time, ns since the epoch
+    uint32_t peer_addr;    // Peer IPv4 address, network byte order
+    uint16_t peer_port;    // Peer TCP port, network byte order
+    uint16_t len;          // Number of frame bytes
+} capture_record_t;
+
+typedef struct
+{
+    FILE *fp;
+    unsigned long records;  // Records written since open
+    uint64_t last_flush_ns; // Arrival time of the last record that flushed the file
+} capture_t;
+
+/*
+ * Open a capture file for appending, writing the file header if the file is new
+ * and validating it otherwise.
+ * Returns: capture handle, NULL on error
+ */
+capture_t *capture_open(const char *path);
+
+/*
+ * Append one frame with its arrival time (taken now) and peer address.
+ * Returns: 0 on success, -1 on error
+ */
+int capture_write(capture_t *cap, uint32_t peer_addr, uint16_t peer_port,
+                  const unsigned char *frame, size_t len);
+
+/*
+ * Write buffered records to the file, e.g. when a connection ends. NULL is ignored.
+ */
+void capture_flush(capture_t *cap);
+
+/*
+ * Flush and close the capture. NULL is ignored.
+ */
+void capture_close(capture_t *cap);
+
+/*
+ * Open a capture file for reading and validate its header.
+ * Returns: file positioned at the first record, NULL on error
+ */
+FILE *capture_open_read(const char *path);
+
+/*
+ * Read the next record. frame must hold CAPTURE_MAX_FRAME bytes.
+ * Returns: 1 if a record was read, 0 at end of file, -1 on a truncated or corrupt record
+ */
+int capture_read(FILE *fp, capture_record_t *rec, unsigned char *frame);
+
+#endif // CAPTURE_H
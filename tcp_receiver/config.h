@@ -2,7 +2,7 @@
  *
  * config.h - configuration header file for TCP receiver application
  * * This file contains configurable parameters such as TCP port, buffer size,
- * * decryption settings, and CMAC size.
+ * * decryption settings, CMAC size and the limits of the per-sensor reorder stage.
  * 
  */
 
@@ -12,7 +12,23 @@
 
 #define TCP_PORT 8000   // Port on which the TCP receiver listens for incoming connections
 #define BUFFER_SIZE 128 // Size of the buffer for receiving data
+#define LISTEN_BACKLOG 128 // Pending connections queued by the kernel before new SYNs are dropped
 #define ENABLE_DECRYPTION 1 // Set to 1 to enable decryption, 0 to disable
 #define CMAC_SIZE 16 // AES-128-CBC CMAC size is 16 bytes
+#define PORTABLE_MAX_CONNS 64 // Client connections the portable recv() path serves at once, each holds one BUFFER_SIZE frame (at most FRAME_MEDIUM_COUNT)
+#define PORTABLE_IDLE_EVICT_MS 1000 // When all connections are taken, one idle this long is closed to admit a new one
+
+// io_uring receive path (Linux only, ignored on other platforms)
+#define ENABLE_IO_URING 1     // Set to 1 to receive via io_uring when liburing is installed (link with -luring), 0 to force the portable recv() path
+#define URING_QUEUE_DEPTH 256 // Number of submission queue entries
+#define URING_BUF_COUNT 256   // Number of BUFFER_SIZE receive buffers in the provided buffer ring (power of two)
+#define URING_BUF_GROUP 1     // Buffer group ID of the provided buffer ring
+
+// Per-sensor reorder stage (see reorder.h)
+#define REORDER_MAX_SENSORS (1 << 18) // Sensors tracked (power of two); samples of further sensors pass through unordered
+#define REORDER_WINDOW 32             // Samples a sensor may run ahead of a missing one (power of two, at most 64)
+#define REORDER_RINGS 4096            // Rings shared by the sensors that currently hold samples
+#define REORDER_LATENESS_MS 100       // Longest a sample waits for a missing predecessor before the gap is skipped
+#define REORDER_STATS_INTERVAL_MS 10000 // Print reorder counters this often
 
 #endif // CONFIG_H
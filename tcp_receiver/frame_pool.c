@@ -0,0 +1,160 @@
+/**
+ * @file frame_pool.c
+ * @brief Slab-backed fixed-size frame pool with per-thread caches, see frame_pool.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "frame_pool.h"
+
+#define FRAME_CLASSES 2
+
+// Stride between frames in a slab, keeping every frame header pointer-aligned
+#define FRAME_STRIDE(size) ((sizeof(frame_t) + (size) + sizeof(void *) - 1) & ~(sizeof(void *) - 1))
+
+typedef struct
+{
+    size_t size;            // Payload bytes per frame
+    size_t count;           // Frames in the slab
+    unsigned char *slab;    // Preallocated frames
+    frame_t *free_list;     // Frames not held by any thread cache
+    pthread_mutex_t lock;   // Protects free_list
+} frame_class_t;
+
+typedef struct
+{
+    frame_t *head;          // Cached free frames
+    unsigned int count;     // Number of cached frames
+} frame_cache_t;
+
+static frame_class_t classes[FRAME_CLASSES] = {
+    {FRAME_SMALL_SIZE, FRAME_SMALL_COUNT, NULL, NULL, PTHREAD_MUTEX_INITIALIZER},
+    {FRAME_MEDIUM_SIZE, FRAME_MEDIUM_COUNT, NULL, NULL, PTHREAD_MUTEX_INITIALIZER},
+};
+
+static __thread frame_cache_t thread_cache[FRAME_CLASSES];
+
+int frame_pool_init(void)
+{
+    for (unsigned int c = 0; c < FRAME_CLASSES; c++)
+    {
+        frame_class_t *fc = &classes[c];
+        size_t stride = FRAME_STRIDE(fc->size);
+
+        if (fc->count == 0)
+            continue; // Class not used by this program
+
+        fc->slab = (unsigned char *)malloc(stride * fc->count);
+        if (fc->slab == NULL)
+        {
+            perror("malloc failed for frame pool slab");
+            frame_pool_destroy();
+            return -1;
+        }
+
+        // Thread the frames onto the free list in address order
+        fc->free_list = NULL;
+        for (size_t i = fc->count; i > 0; i--)
+        {
+            frame_t *frame = (frame_t *)(fc->slab + (i - 1) * stride);
+            frame->cls = c;
+            frame->len = 0;
+            frame->next = fc->free_list;
+            fc->free_list = frame;
+        }
+    }
+    return 0;
+}
+
+void frame_pool_destroy(void)
+{
+    for (unsigned int c = 0; c < FRAME_CLASSES; c++)
+    {
+        free(classes[c].slab);
+        classes[c].slab = NULL;
+        classes[c].free_list = NULL;
+        thread_cache[c].head = NULL;
+        thread_cache[c].count = 0;
+    }
+}
+
+// Move up to FRAME_CACHE_BATCH frames from the shared free list into this thread's cache
+static void cache_refill(unsigned int c)
+{
+    frame_class_t *fc = &classes[c];
+    frame_cache_t *cache = &thread_cache[c];
+
+    pthread_mutex_lock(&fc->lock);
+    while (fc->free_list != NULL && cache->count < FRAME_CACHE_BATCH)
+    {
+        frame_t *frame = fc->free_list;
+        fc->free_list = frame->next;
+        frame->next = cache->head;
+        cache->head = frame;
+        cache->count++;
+    }
+    pthread_mutex_unlock(&fc->lock);
+}
+
+// Return FRAME_CACHE_BATCH frames from this thread's cache to the shared free list
+static void cache_drain(unsigned int c)
+{
+    frame_class_t *fc = &classes[c];
+    frame_cache_t *cache = &thread_cache[c];
+
+    pthread_mutex_lock(&fc->lock);
+    for (unsigned int i = 0; i < FRAME_CACHE_BATCH && cache->head != NULL; i++)
+    {
+        frame_t *frame = cache->head;
+        cache->head = frame->next;
+        cache->count--;
+        frame->next = fc->free_list;
+        fc->free_list = frame;
+    }
+    pthread_mutex_unlock(&fc->lock);
+}
+
+frame_t *frame_alloc(size_t size)
+{
+    unsigned int c = 0;
+    while (c < FRAME_CLASSES && (classes[c].size < size || classes[c].count == 0))
+        c++;
+    if (c == FRAME_CLASSES)
+        return NULL; // Larger than the largest configured class
+
+    frame_cache_t *cache = &thread_cache[c];
+    if (cache->head == NULL)
+    {
+        cache_refill(c);
+        if (cache->head == NULL)
+            return NULL; // Class exhausted
+    }
+
+    frame_t *frame = cache->head;
+    cache->head = frame->next;
+    cache->count--;
+    frame->next = NULL;
+    frame->len = 0;
+    return frame;
+}
+
+void frame_free(frame_t *frame)
+{
+    if (frame == NULL)
+        return;
+
+    frame_cache_t *cache = &thread_cache[frame->cls];
+    frame->next = cache->head;
+    cache->head = frame;
+    cache->count++;
+
+    if (cache->count > FRAME_CACHE_MAX)
+        cache_drain(frame->cls);
+}
+
+size_t frame_capacity(const frame_t *frame)
+{
+    return classes[frame->cls].size;
+}
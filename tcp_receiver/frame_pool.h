@@ -0,0 +1,72 @@
+/**
+ * @file frame_pool.h
+ * @brief Fixed-size frame pool used for receive, ciphertext and plaintext buffers.
+ * @details
+ *  Frames are carved at start-up from one preallocated slab per size class, so the steady state
+ *  does no heap allocation and memory use is known up front. Each thread keeps a small cache of
+ *  free frames per class and only takes the pool lock to move FRAME_CACHE_BATCH frames at a time.
+ *  A frame is owned by exactly one stage at a time (recv -> verify -> decrypt -> sink) and the
+ *  last owner returns it with frame_free().
+ *  The same module is used by the sensor and TCP receiver projects.
+ */
+
+#ifndef FRAME_POOL_H
+#define FRAME_POOL_H
+
+#include <stddef.h>
+
+// Size classes: one encrypted sample (ciphertext + CMAC, or its plaintext), and one receive buffer
+// (BUFFER_SIZE of the TCP receiver). Override at compile time to match the program; a class with
+// a count of 0 is not allocated (the sensor server builds with FRAME_MEDIUM_COUNT=0).
+#ifndef FRAME_SMALL_SIZE
+#define FRAME_SMALL_SIZE 64    // Bytes per small frame
+#endif
+#ifndef FRAME_SMALL_COUNT
+#define FRAME_SMALL_COUNT 1024 // Number of small frames
+#endif
+#ifndef FRAME_MEDIUM_SIZE
+#define FRAME_MEDIUM_SIZE 128  // Bytes per medium frame
+#endif
+#ifndef FRAME_MEDIUM_COUNT
+#define FRAME_MEDIUM_COUNT 64  // Number of medium frames, one per client connection of the receiver
+#endif
+
+#define FRAME_CACHE_MAX 32   // Free frames a thread may keep per class before returning some to the pool
+#define FRAME_CACHE_BATCH 16 // Frames moved between a thread cache and the pool at once
+
+typedef struct frame
+{
+    struct frame *next;  // Free list link while the frame is not owned
+    unsigned int cls;    // Size class the frame belongs to
+    unsigned int len;    // Number of valid bytes in data
+    unsigned char data[]; // Frame payload, frame_capacity() bytes
+} frame_t;
+
+/*
+ * Preallocate all size classes. Must be called once before any other frame function.
+ * Returns: 0 on success, -1 on allocation failure
+ */
+int frame_pool_init(void);
+
+/*
+ * Release the slabs. No frame may be in use.
+ */
+void frame_pool_destroy(void);
+
+/*
+ * Take a frame able to hold at least size bytes from the smallest fitting class.
+ * Returns: the frame with len set to 0, or NULL if size is too large or the class is exhausted
+ */
+frame_t *frame_alloc(size_t size);
+
+/*
+ * Return a frame to the pool. NULL is ignored.
+ */
+void frame_free(frame_t *frame);
+
+/*
+ * Returns: number of payload bytes the frame can hold
+ */
+size_t frame_capacity(const frame_t *frame);
+
+#endif // FRAME_POOL_H
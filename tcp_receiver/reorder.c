@@ -0,0 +1,387 @@
+/**
+ * @file reorder.c
+ * @brief Per-sensor reorder buffer with gap detection, see reorder.h.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "config.h"
+#include "reorder.h"
+
+#if (REORDER_WINDOW & (REORDER_WINDOW - 1)) != 0 || REORDER_WINDOW > 64
+#error "REORDER_WINDOW must be a power of two no larger than 64"
+#endif
+#if (REORDER_MAX_SENSORS & (REORDER_MAX_SENSORS - 1)) != 0
+#error "REORDER_MAX_SENSORS must be a power of two"
+#endif
+
+#define REORDER_TABLE_SIZE (2 * REORDER_MAX_SENSORS) // Hash table slots, kept at most half full
+#define REORDER_MASK (REORDER_WINDOW - 1)
+#define REORDER_NONE 0xFFFFFFFFu                     // No ring / end of list
+
+// Hash table entry, one per sensor seen
+typedef struct
+{
+    uint64_t newest_ts_us; // Newest timestamp accepted so far, whether released or still held
+    uint32_t sensor_id;
+    uint32_t next_seq;   // Sequence number the sink expects next
+    uint32_t ring;       // Ring holding samples that arrived ahead of next_seq, REORDER_NONE if none
+    uint32_t used;       // Entry holds a sensor
+} reorder_sensor_t;
+
+// Samples of one sensor waiting for a missing predecessor, indexed by seq % REORDER_WINDOW
+typedef struct
+{
+    uint64_t present;       // Bit (seq % REORDER_WINDOW) is set while that sample is held
+    uint64_t waiting_since; // When the sensor started waiting on its current gap
+    uint32_t sensor;        // Owning table entry
+    uint32_t prev, next;    // Expiry list links while lent; next links the free list otherwise
+    sensor_record_t samples[REORDER_WINDOW];
+} reorder_ring_t;
+
+static reorder_sensor_t *sensors = NULL;
+static reorder_ring_t *rings = NULL;
+static uint32_t free_rings = REORDER_NONE;
+// Lent rings in the order their sensors started waiting, so the first one expires first
+static uint32_t wait_head = REORDER_NONE, wait_tail = REORDER_NONE;
+static uint32_t rings_lent = 0;
+static uint32_t sensors_tracked = 0;
+static reorder_sink_t sink = NULL;
+
+static struct
+{
+    unsigned long in_order;  // Released as soon as they arrived
+    unsigned long reordered; // Held until their predecessors arrived or were given up
+    unsigned long gaps;      // Samples given up as lost
+    unsigned long late;      // Arrived after their slot was released, or twice: dropped
+    unsigned long forced;    // Held samples released early: window overrun or no free ring
+    unsigned long restarts;  // Sensor restarts detected
+    unsigned long untracked; // Passed through unordered because the sensor table is full
+} stats;
+
+uint64_t reorder_now_ns(void)
+{
+    struct timespec ts;
+#ifdef CLOCK_MONOTONIC
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+#else
+    timespec_get(&ts, TIME_UTC); // Windows
+#endif
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+// murmur3 finaliser: sequential sensor IDs spread over the whole table
+static uint32_t hash_id(uint32_t id)
+{
+    id ^= id >> 16;
+    id *= 0x85ebca6bu;
+    id ^= id >> 13;
+    id *= 0xc2b2ae35u;
+    id ^= id >> 16;
+    return id;
+}
+
+/*
+ * Look up a sensor, adding it on first sight (linear probing).
+ * created: Set to 1 if the entry was just added
+ * Returns: the entry, NULL if the sensor is new and the table is full
+ */
+static reorder_sensor_t *find_sensor(uint32_t sensor_id, int *created)
+{
+    uint32_t i = hash_id(sensor_id) & (REORDER_TABLE_SIZE - 1);
+
+    *created = 0;
+    while (sensors[i].used)
+    {
+        if (sensors[i].sensor_id == sensor_id)
+            return &sensors[i];
+        i = (i + 1) & (REORDER_TABLE_SIZE - 1);
+    }
+    if (sensors_tracked == REORDER_MAX_SENSORS)
+        return NULL;
+
+    sensors_tracked++;
+    sensors[i].used = 1;
+    sensors[i].sensor_id = sensor_id;
+    sensors[i].ring = REORDER_NONE;
+    *created = 1;
+    return &sensors[i];
+}
+
+static void wait_append(uint32_t i)
+{
+    rings[i].prev = wait_tail;
+    rings[i].next = REORDER_NONE;
+    if (wait_tail != REORDER_NONE)
+        rings[wait_tail].next = i;
+    else
+        wait_head = i;
+    wait_tail = i;
+}
+
+static void wait_remove(uint32_t i)
+{
+    if (rings[i].prev != REORDER_NONE)
+        rings[rings[i].prev].next = rings[i].next;
+    else
+        wait_head = rings[i].next;
+    if (rings[i].next != REORDER_NONE)
+        rings[rings[i].next].prev = rings[i].prev;
+    else
+        wait_tail = rings[i].prev;
+}
+
+// Hand a sample to the sink and move the sensor past it
+static void release(reorder_sensor_t *s, const sensor_record_t *record)
+{
+    s->next_seq = record->seq + 1;
+    if (record->timestamp_us > s->newest_ts_us)
+        s->newest_ts_us = record->timestamp_us;
+    sink(record);
+}
+
+// Return an emptied ring to the free list
+static void put_ring(reorder_sensor_t *s)
+{
+    uint32_t i = s->ring;
+
+    wait_remove(i);
+    rings[i].next = free_rings;
+    free_rings = i;
+    s->ring = REORDER_NONE;
+    rings_lent--;
+}
+
+// The sensor moved on but still holds samples: it now waits on a new gap, which gets a lateness period of its own
+static void restart_wait(reorder_sensor_t *s, uint64_t now_ns)
+{
+    if (s->ring == REORDER_NONE)
+        return;
+    wait_remove(s->ring);
+    rings[s->ring].waiting_since = now_ns;
+    wait_append(s->ring);
+}
+
+// Release held samples for as long as they continue the sequence
+static void drain(reorder_sensor_t *s, uint64_t now_ns)
+{
+    uint32_t first_seq = s->next_seq;
+
+    while (s->ring != REORDER_NONE)
+    {
+        reorder_ring_t *r = &rings[s->ring];
+        uint64_t bit = 1ull << (s->next_seq & REORDER_MASK);
+
+        if (!(r->present & bit))
+            break;
+        r->present &= ~bit;
+        release(s, &r->samples[s->next_seq & REORDER_MASK]);
+        if (r->present == 0)
+            put_ring(s);
+    }
+    if (s->next_seq != first_seq)
+        restart_wait(s, now_ns);
+}
+
+// Give up on the samples missing before the first held one, then release what follows
+static void skip_gap(reorder_sensor_t *s, uint64_t now_ns)
+{
+    const reorder_ring_t *r = &rings[s->ring];
+
+    // A held sample lies within the window, so this stops after fewer than REORDER_WINDOW steps
+    while (!(r->present & (1ull << (s->next_seq & REORDER_MASK))))
+    {
+        s->next_seq++;
+        stats.gaps++;
+    }
+    drain(s, now_ns);
+}
+
+// Release everything held for a sensor, skipping any gaps in between
+static void flush(reorder_sensor_t *s, uint64_t now_ns)
+{
+    while (s->ring != REORDER_NONE)
+        skip_gap(s, now_ns);
+}
+
+// Move a sensor's expected sequence number forward to base, releasing or skipping everything before it
+static void advance(reorder_sensor_t *s, uint32_t base, uint64_t now_ns)
+{
+    while (s->ring != REORDER_NONE && (int32_t)(base - s->next_seq) > 0)
+    {
+        reorder_ring_t *r = &rings[s->ring];
+        uint64_t bit = 1ull << (s->next_seq & REORDER_MASK);
+
+        if (r->present & bit)
+        {
+            r->present &= ~bit;
+            release(s, &r->samples[s->next_seq & REORDER_MASK]);
+            if (r->present == 0)
+                put_ring(s);
+        }
+        else
+        {
+            s->next_seq++;
+            stats.gaps++;
+        }
+    }
+    if ((int32_t)(base - s->next_seq) > 0)
+    {
+        stats.gaps += base - s->next_seq;
+        s->next_seq = base;
+    }
+    restart_wait(s, now_ns);
+}
+
+// Lend a ring to a sensor; if none is free, the sensor that has waited longest gives its ring up early
+static void get_ring(reorder_sensor_t *s, uint64_t now_ns)
+{
+    if (free_rings == REORDER_NONE)
+    {
+        stats.forced++;
+        flush(&sensors[rings[wait_head].sensor], now_ns);
+    }
+
+    uint32_t i = free_rings;
+    reorder_ring_t *r = &rings[i];
+    free_rings = r->next;
+    r->present = 0;
+    r->waiting_since = now_ns;
+    r->sensor = (uint32_t)(s - sensors);
+    wait_append(i);
+    s->ring = i;
+    rings_lent++;
+}
+
+int reorder_init(reorder_sink_t sample_sink)
+{
+    sensors = (reorder_sensor_t *)calloc(REORDER_TABLE_SIZE, sizeof(reorder_sensor_t));
+    rings = (reorder_ring_t *)calloc(REORDER_RINGS, sizeof(reorder_ring_t));
+    if (sensors == NULL || rings == NULL)
+    {
+        free(sensors);
+        free(rings);
+        sensors = NULL;
+        rings = NULL;
+        return -1;
+    }
+
+    for (uint32_t i = 0; i < REORDER_RINGS; i++)
+        rings[i].next = i + 1 < REORDER_RINGS ? i + 1 : REORDER_NONE;
+    free_rings = 0;
+    wait_head = wait_tail = REORDER_NONE;
+    rings_lent = 0;
+    sensors_tracked = 0;
+    sink = sample_sink;
+    memset(&stats, 0, sizeof(stats));
+    return 0;
+}
+
+void reorder_destroy(void)
+{
+    if (sensors == NULL)
+        return;
+    uint64_t now_ns = reorder_now_ns();
+    while (wait_head != REORDER_NONE)
+        flush(&sensors[rings[wait_head].sensor], now_ns);
+    free(sensors);
+    free(rings);
+    sensors = NULL;
+    rings = NULL;
+}
+
+void reorder_push(const sensor_record_t *record, uint64_t now_ns)
+{
+    int created;
+    reorder_sensor_t *s = find_sensor(record->sensor_id, &created);
+
+    if (s == NULL)
+    {
+        stats.untracked++;
+        sink(record);
+        return;
+    }
+    if (created)
+    {
+        // First sample of this sensor starts its sequence
+        stats.in_order++;
+        release(s, record);
+        return;
+    }
+
+    int32_t ahead = (int32_t)(record->seq - s->next_seq);
+    if (ahead < 0)
+    {
+        // A late sample is older than the samples accepted after it, including the held one that
+        // made a forced advance skip it. One that is newer means the sensor restarted its
+        // sequence: finish the old stream and follow the new one.
+        if (record->timestamp_us > s->newest_ts_us)
+        {
+            stats.restarts++;
+            flush(s, now_ns);
+            stats.in_order++;
+            release(s, record);
+            return;
+        }
+        stats.late++;
+        return;
+    }
+
+    if (ahead >= REORDER_WINDOW)
+    {
+        // Too far ahead to hold: give up on the oldest missing samples so this one fits the window
+        if (s->ring != REORDER_NONE)
+            stats.forced++;
+        advance(s, record->seq - REORDER_MASK, now_ns);
+        ahead = REORDER_MASK;
+    }
+
+    if (ahead == 0)
+    {
+        stats.in_order++;
+        release(s, record);
+    }
+    else
+    {
+        if (s->ring == REORDER_NONE)
+            get_ring(s, now_ns);
+        if (record->timestamp_us > s->newest_ts_us)
+            s->newest_ts_us = record->timestamp_us;
+
+        reorder_ring_t *r = &rings[s->ring];
+        uint64_t bit = 1ull << (record->seq & REORDER_MASK);
+        if (r->present & bit)
+        {
+            stats.late++; // Duplicate of a held sample
+        }
+        else
+        {
+            r->samples[record->seq & REORDER_MASK] = *record;
+            r->present |= bit;
+            stats.reordered++;
+        }
+    }
+    // Also releases samples that a forced advance left at the head of the window
+    drain(s, now_ns);
+}
+
+uint64_t reorder_expire(uint64_t now_ns)
+{
+    const uint64_t lateness_ns = REORDER_LATENESS_MS * 1000000ull;
+
+    // A sensor still waiting on a later gap after skip_gap() moves to the back of the list
+    while (wait_head != REORDER_NONE && now_ns >= rings[wait_head].waiting_since + lateness_ns)
+        skip_gap(&sensors[rings[wait_head].sensor], now_ns);
+    return wait_head != REORDER_NONE ? rings[wait_head].waiting_since + lateness_ns : 0;
+}
+
+void reorder_print_stats(void)
+{
+    printf("Reorder: sensors=%u waiting=%u in_order=%lu reordered=%lu gaps=%lu late=%lu forced=%lu "
+           "restarts=%lu untracked=%lu\n",
+           sensors_tracked, rings_lent, stats.in_order, stats.reordered, stats.gaps, stats.late,
+           stats.forced, stats.restarts, stats.untracked);
+}
@@ -0,0 +1,66 @@
+/**
+ * @file reorder.h
+ * @brief Per-sensor reorder stage between frame decoding and the sample sink.
+ * @details
+ *  Samples of one sensor can arrive out of order once they travel over several connections,
+ *  retries or uplinks. This stage releases every sensor's samples to the sink in sequence order:
+ *  a sample that arrives in order is released at once, one that arrives ahead of a missing
+ *  predecessor is held until the gap fills or REORDER_LATENESS_MS passes, after which the missing
+ *  samples are counted as a gap and skipped. The period restarts whenever the sensor moves on to
+ *  a later gap. Samples arriving after their slot was released or skipped are dropped as late.
+ *  A sequence number that goes backwards with a newer timestamp than anything accepted so far,
+ *  released or held, is a restarted sensor and resynchronises the stream.
+ *
+ *  Memory is fixed at start-up: a hash table of REORDER_MAX_SENSORS sensors, and REORDER_RINGS
+ *  rings of REORDER_WINDOW samples that are lent only to sensors which currently hold samples.
+ *  Sensors with nothing held, which is nearly all of them, cost one table entry. If every ring
+ *  is lent out, the ring of the sensor that has been waiting longest is released early.
+ *  Insertion is O(1); expiry and ring release are amortized O(1) per sample.
+ */
+
+#ifndef REORDER_H
+#define REORDER_H
+
+#include <stdint.h>
+
+#include "sensor_record.h"
+
+// Receives samples in per-sensor sequence order
+typedef void (*reorder_sink_t)(const sensor_record_t *record);
+
+/*
+ * Allocate the sensor table and the ring pool. Must be called once before any other reorder function.
+ * sink: Called for every released sample
+ * Returns: 0 on success, -1 on allocation failure
+ */
+int reorder_init(reorder_sink_t sink);
+
+/*
+ * Release all held samples in order and free the tables.
+ */
+void reorder_destroy(void);
+
+/*
+ * Pass one decoded sample through the reorder stage. The record is copied if it has to be held.
+ * now_ns: Arrival time from reorder_now_ns()
+ */
+void reorder_push(const sensor_record_t *record, uint64_t now_ns);
+
+/*
+ * Skip the gaps that sensors have been waiting on for longer than REORDER_LATENESS_MS and
+ * release the samples behind them.
+ * Returns: reorder_now_ns() time at which reorder_expire() must run again, 0 if nothing is held
+ */
+uint64_t reorder_expire(uint64_t now_ns);
+
+/*
+ * Print the reorder counters (in order, reordered, gaps, late drops, forced releases, restarts).
+ */
+void reorder_print_stats(void);
+
+/*
+ * Returns: current monotonic time in ns
+ */
+uint64_t reorder_now_ns(void);
+
+#endif // REORDER_H
@@ -0,0 +1,29 @@
+/**
+ * @file sensor_record.h
+ * @brief Plaintext layout of the frames sent by the sensor server (must match sensor/sensor_def.h).
+ */
+
+#ifndef SENSOR_RECORD_H
+#define SENSOR_RECORD_H
+
+#include <stdint.h>
+
+// Structure to hold sensor data
+typedef struct
+{
+    float temperature; // in °C
+    float speed;       // in km/h
+    float latitude;    // GPS latitude
+    float longitude;   // GPS longitude
+} sensor_data_t;
+
+// One sample as carried by a frame
+typedef struct
+{
+    uint32_t sensor_id;    // Sensor that took the sample
+    uint32_t seq;          // Per-sensor sequence number, starts at 0 and wraps
+    uint64_t timestamp_us; // Sampling time, microseconds since the epoch
+    sensor_data_t data;
+} sensor_record_t;
+
+#endif // SENSOR_RECORD_H
@@ -1,12 +1,20 @@
 /**
  * * @file tcp_receiver.c
  * * @brief TCP receiver application that listens for sensor data, decrypts it using AES-128-CBC,
- * *        verifies its integrity using CMAC, and prints the sensor data.
+ * *        verifies its integrity using CMAC, and prints the sensor data in per-sensor sequence order.
  * * * This application is designed to run on a server that receives encrypted sensor data over TCP.
  * * * It uses OpenSSL for cryptographic operations and can be compiled on both Windows and QNX.    
  * * * @note This code requires OpenSSL library to be installed and linked during compilation.
+ * * * @note Build together with frame_pool.c, which provides the preallocated frame buffers,
+ * * *       capture.c, which records raw inbound frames when started with -w <capture_file>,
+ * * *       and reorder.c, which restores each sensor's sample order and counts gaps and late samples.
  * * * @note Ensure to define the AES key and IV in aes_key.h before compiling.
  * * * @note The TCP port can be configured in tcp_conf.h.  
+ * * * @note On Linux the receive path uses io_uring when ENABLE_IO_URING is set in config.h and the
+ * * *       liburing headers are installed; link with -luring in that case, e.g.
+ * * *       gcc tcp_receiver.c frame_pool.c capture.c reorder.c -lssl -lcrypto -lpthread -luring
+ * * *       Without liburing it builds the portable recv() path only, which is also the runtime
+ * * *       fallback when the kernel does not support io_uring.
  * * * @author mohamed.elkahwagy@seitech-solutions.com
  * * * @date 07-July-2025
  */
@@ -14,6 +22,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <signal.h>
 #include <openssl/evp.h>
 #include <openssl/aes.h>
 #include <openssl/err.h>
@@ -27,19 +36,48 @@
 #include <sys/socket.h>
 #include <arpa/inet.h>
 #include <netinet/in.h>
+#include <sys/select.h>
+#define closesocket close
 #endif
 #include "config.h"
 #include "aes_key.h"
+#include "sensor_record.h"
+#include "frame_pool.h"
+#include "capture.h"
+#include "reorder.h"
+
+// io_uring is only built in when liburing's headers are installed, so the receiver still
+// builds on Linux hosts without them
+#if defined(__linux__) && ENABLE_IO_URING && defined(__has_include)
+#if __has_include(<liburing.h>)
+#define USE_IO_URING 1
+#include <errno.h>
+#include <liburing.h>
+#endif
+#endif
+#ifndef USE_IO_URING
+#define USE_IO_URING 0
+#endif
 
+// Size of one frame on the wire: PKCS#7 padded ciphertext plus CMAC, or the raw structure.
+// A connection carries one or more frames back to back.
+#if ENABLE_DECRYPTION
+#define WIRE_FRAME_SIZE ((int)((sizeof(sensor_record_t) / 16 + 1) * 16 + CMAC_SIZE))
+#else
+#define WIRE_FRAME_SIZE ((int)sizeof(sensor_record_t))
+#endif
 
-// Structure to hold sensor data
-typedef struct
-{
-    float temperature; // in °C
-    float speed;       // in km/h
-    float latitude;    // GPS latitude
-    float longitude;   // GPS longitude
-} sensor_data_t;
+// Raw frame capture, NULL unless enabled with -w <capture_file>
+static capture_t *capture = NULL;
+
+// Samples go through the reorder stage unless disabled with -u, e.g. to receive a tcp_replay
+static int reorder_enabled = 1;
+
+// Set by SIGINT/SIGTERM: the receive loops return so the capture is flushed and closed
+static volatile sig_atomic_t stop_requested = 0;
+
+// Next time the reorder counters are printed
+static uint64_t next_stats_ns = 0;
 
 /* 
  * Function to decrypt AES-128-CBC encrypted data
@@ -51,7 +89,7 @@ typedef struct
  * Returns: Length of the decrypted plaintext, -1 on error
  * Note: The plaintext buffer should be large enough to hold the decrypted data 
  */
-int decrypt(unsigned char *ciphertext, int ciphertext_len,
+int decrypt(const unsigned char *ciphertext, int ciphertext_len,
             unsigned char *key, unsigned char *iv,
             unsigned char *plaintext)
 {
@@ -63,23 +101,37 @@ int decrypt(unsigned char *ciphertext, int ciphertext_len,
 
     int len = 0, plaintext_len = 0;
 
-    // Create and initialize the context for decryption
-    EVP_CIPHER_CTX *ctx = EVP_CIPHER_CTX_new();
+    // The context is created once and reused for every frame to keep the receive path allocation free
+    static EVP_CIPHER_CTX *ctx = NULL;
+    if (ctx == NULL)
+    {
+        ctx = EVP_CIPHER_CTX_new();
+        if (ctx == NULL)
+            return -1;
+
+        // Initialize decryption operation with AES-128-CBC
+        if (!EVP_DecryptInit_ex(ctx, EVP_aes_128_cbc(), NULL, NULL, NULL))
+        {
+            EVP_CIPHER_CTX_free(ctx);
+            ctx = NULL;
+            return -1;
+        }
+    }
 
-    // Initialize decryption operation with AES-128-CBC
-    EVP_DecryptInit_ex(ctx, EVP_aes_128_cbc(), NULL, key, iv);
+    // Set key and IV for this frame (resets any state left by the previous frame)
+    if (!EVP_DecryptInit_ex(ctx, NULL, NULL, key, iv))
+        return -1;
 
     // Decrypt the ciphertext (may be called multiple times for large data)
-    EVP_DecryptUpdate(ctx, plaintext, &len, ciphertext, ciphertext_len);
+    if (!EVP_DecryptUpdate(ctx, plaintext, &len, ciphertext, ciphertext_len))
+        return -1;
     plaintext_len = len;
 
     // Finalize decryption (handles padding)
-    EVP_DecryptFinal_ex(ctx, plaintext + len, &len);
+    if (!EVP_DecryptFinal_ex(ctx, plaintext + len, &len))
+        return -1;
     plaintext_len += len;
 
-    // Clean up
-    EVP_CIPHER_CTX_free(ctx);
-
     // Return total length of decrypted plaintext
     return plaintext_len;
 }
@@ -99,238 +151,839 @@ int verify_cmac(const unsigned char *key,
     unsigned char expected_cmac[CMAC_SIZE];
     size_t cmac_len = 0;
 
-    CMAC_CTX *ctx = CMAC_CTX_new();
-    if (!ctx)
-        return -1;
+    // The context is created once; while the key is unchanged it is only restarted per frame
+    static CMAC_CTX *ctx = NULL;
+    static const unsigned char *ctx_key = NULL;
+    if (ctx == NULL)
+    {
+        ctx = CMAC_CTX_new();
+        if (!ctx)
+            return -1;
+    }
 
-    // Initialize CMAC context with AES-128-CBC
-    if (!CMAC_Init(ctx, key, 16, EVP_aes_128_cbc(), NULL))
+    if (key != ctx_key)
     {
-        CMAC_CTX_free(ctx);
+        // Initialize CMAC context with AES-128-CBC
+        ctx_key = NULL;
+        if (!CMAC_Init(ctx, key, 16, EVP_aes_128_cbc(), NULL))
+            return -1;
+        ctx_key = key;
+    }
+    else if (!CMAC_Init(ctx, NULL, 0, NULL, NULL))
+    {
+        // Restart with the key and cipher already set up
         return -1;
     }
 
     // Update CMAC with ciphertext
     if (!CMAC_Update(ctx, ciphertext, ciphertext_len))
-    {
-        CMAC_CTX_free(ctx);
         return -1;
-    }
 
     // Finalize and get the computed CMAC
     if (!CMAC_Final(ctx, expected_cmac, &cmac_len))
-    {
-        CMAC_CTX_free(ctx);
         return -1;
-    }
-
-    CMAC_CTX_free(ctx);
 
     // Compare computed CMAC with received CMAC
     return (cmac_len == CMAC_SIZE && memcmp(expected_cmac, received_cmac, CMAC_SIZE) == 0) ? 1 : 0;
 }
 
-int main()
+// SIGINT/SIGTERM handler: only sets the flag, the receive loops do the shutdown
+void on_stop_signal(int sig)
 {
-    int server_fd, client_fd, bytes_received;
-    struct sockaddr_in server_addr, client_addr;
-    socklen_t addr_len = sizeof(client_addr);
-    sensor_data_t sensor_data; // Structure to hold received sensor data
-    unsigned char *buffer = NULL;
+    (void)sig;
+    stop_requested = 1;
+}
 
-#ifdef _WIN32
-    // Initialize Winsock on Windows
-    WSADATA wsaData;
-    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+/*
+ * Function to run the periodic work of the reorder stage: skip gaps whose lateness bound has
+ * passed and print the counters when due
+ * Returns: Time (reorder_now_ns()) at which it must run again: the next lateness bound of held
+ *          samples or the next counter print, whichever comes first, so an idle receiver prints too
+ */
+uint64_t receiver_tick(void)
+{
+    uint64_t now = reorder_now_ns();
+    uint64_t next = reorder_expire(now);
+
+    if (now >= next_stats_ns)
     {
-        fprintf(stderr, "WSAStartup failed.\n");
-        return EXIT_FAILURE;
+        if (reorder_enabled)
+            reorder_print_stats();
+        next_stats_ns = now + REORDER_STATS_INTERVAL_MS * 1000000ull;
     }
-#endif
+    return next != 0 && next < next_stats_ns ? next : next_stats_ns;
+}
 
-    // Create a TCP socket
-    server_fd = socket(AF_INET, SOCK_STREAM, 0);
-    if (server_fd == -1)
+/*
+ * Function to consume one sample released by the reorder stage (the sink of the receive pipeline)
+ * record: Sample, released in sequence order for its sensor
+ */
+void print_sample(const sensor_record_t *record)
+{
+    const sensor_data_t *sensor_data = &record->data;
+
+    // Print decrypted sensor data
+    printf("Decrypted Sensor Data:: ");
+    printf("Sensor %u seq %u, Temperature: %.1f°C, Speed: %.1f km/h, GPS: (%.4f, %.4f)\n",
+           record->sensor_id, record->seq, sensor_data->temperature, sensor_data->speed,
+           sensor_data->latitude, sensor_data->longitude);
+}
+
+/*
+ * Function to hand one decoded sample to the reorder stage, or straight to print_sample() with -u
+ * sample: Pool frame holding a sensor_record_t; ownership passes to this function
+ */
+void deliver_sample(frame_t *sample)
+{
+    sensor_record_t record;
+
+    // The frame goes back to the pool right away; the reorder stage copies what it has to hold
+    memcpy(&record, sample->data, sizeof(record));
+    frame_free(sample);
+    if (reorder_enabled)
+        reorder_push(&record, reorder_now_ns());
+    else
+        print_sample(&record);
+}
+
+/*
+ * Function to process one received frame (ciphertext + CMAC, or raw sensor_record_t when
+ * decryption is disabled) and hand the sample it carries to the reorder stage.
+ * frame: The received bytes, verified and decrypted in place without copying; the caller keeps ownership
+ * frame_len: Number of bytes received
+ * Returns: 0 on success, -1 if the frame was rejected
+ */
+int process_frame(const unsigned char *frame, int frame_len)
+{
+    frame_t *sample = NULL; // Pool frame holding the decoded sensor_record_t
+
+#if ENABLE_DECRYPTION
+    // Check if received data is large enough to contain CMAC
+    if (frame_len < CMAC_SIZE)
     {
-        perror("socket");
-        exit(EXIT_FAILURE);
+        fprintf(stderr, "Received data too short for CMAC\n");
+        return -1;
     }
 
-    // Setup server address structure
-    memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_port = htons(TCP_PORT);
-    server_addr.sin_addr.s_addr = INADDR_ANY;
+    // Ciphertext is followed by the CMAC in the received buffer
+    int ciphertext_len = frame_len - CMAC_SIZE;
+    const unsigned char *ciphertext = frame;
+    const unsigned char *recvd_cmac = frame + ciphertext_len;
 
-    // Bind socket to the specified port
-    if (bind(server_fd, (struct sockaddr *)&server_addr, sizeof(server_addr)) == -1)
+    // Verify CMAC to ensure data integrity and authenticity
+    printf("Verifying CMAC...   \n");
+    int verified = verify_cmac(aes_key, ciphertext, ciphertext_len, recvd_cmac);
+    if (verified != 1)
     {
-        perror("bind");
-#ifdef _WIN32
-        closesocket(server_fd);
-#else
-        close(server_fd);
-#endif
-        exit(EXIT_FAILURE);
+        fprintf(stderr, /* RED */"\033[1;31mCMAC verification failed! Possible tampering attempt!!!\033[0m\n"/* RESET */);
+        return -1;
     }
+    printf("\033[1;32mCMAC verification successful!!\033[0m\n");
 
-    // Start listening for incoming connections
-    if (listen(server_fd, 5) == -1)
+    /* Decrypt the ciphertext */
+    sample = frame_alloc(ciphertext_len);
+    if (sample == NULL)
     {
-        perror("listen");
-        closesocket(server_fd);
-        exit(EXIT_FAILURE);
+        fprintf(stderr, "Frame pool exhausted, dropping %d byte frame\n", frame_len);
+        return -1;
     }
 
-    printf("TCP Receiver started. Listening on port %d...\n", TCP_PORT);
+    int decrypted_len = decrypt(ciphertext, ciphertext_len,
+                                (unsigned char *)aes_key, (unsigned char *)aes_iv, sample->data);
 
-    // Main server loop: accept and process incoming connections
-    while (1)
+    if (decrypted_len < 0)
+    {
+        fprintf(stderr, "Decryption failed!!\n");
+        frame_free(sample);
+        return -1;
+    }
+    // Check if the decrypted data size matches the expected structure size.
+    // This is important to detect protocol errors or incorrect padding after decryption.
+    if (decrypted_len != sizeof(sensor_record_t))
     {
-        puts("------------------------------------------------------------------------------------------");
+        fprintf(stderr, "Decrypted data size mismatch: expected %zu, got %d\n", sizeof(sensor_record_t), decrypted_len);
+        frame_free(sample);
+        return -1;
+    }
+    sample->len = decrypted_len;
+#else
+    // If not decrypting, expect raw sensor_record_t structure
+    if (frame_len != sizeof(sensor_record_t))
+    {
+        fprintf(stderr, "Received data size mismatch: expected %zu, got %d\n", sizeof(sensor_record_t), frame_len);
+        return -1;
+    }
+    sample = frame_alloc(sizeof(sensor_record_t));
+    if (sample == NULL)
+    {
+        fprintf(stderr, "Frame pool exhausted, dropping %d byte frame\n", frame_len);
+        return -1;
+    }
+    memcpy(sample->data, frame, sizeof(sensor_record_t));
+    sample->len = sizeof(sensor_record_t);
+#endif
+    deliver_sample(sample);
+    return 0;
+}
 
-        // Accept a new client connection
-        client_fd = accept(server_fd, (struct sockaddr *)&client_addr, &addr_len);
-        if (client_fd == -1)
-        {
+#if PORTABLE_MAX_CONNS > FRAME_MEDIUM_COUNT
+#error "PORTABLE_MAX_CONNS must not exceed FRAME_MEDIUM_COUNT, each connection holds one receive frame"
+#endif
+
+// One client connection of the portable recv() path
+typedef struct
+{
+    int fd;                      // Client socket, -1 while the slot is free
+    struct sockaddr_in addr;     // Peer address, recorded with captured frames
+    frame_t *rx_frame;           // Pool buffer collecting the frame being received
+    int got;                     // Bytes of that frame received so far
+    uint64_t last_rx_ns;         // reorder_now_ns() of the last receive, to pick a connection to evict
+} portable_conn_t;
+
+static portable_conn_t portable_conns[PORTABLE_MAX_CONNS];
+
+// Capture and process the frame collected by a connection, complete or (at end of stream) truncated
+static void portable_frame(portable_conn_t *conn)
+{
+    puts("------------------------------------------------------------------------------------------");
+    printf("Received %d bytes from client\n", conn->got);
+
+    conn->rx_frame->len = conn->got;
+    if (capture)
+        capture_write(capture, conn->addr.sin_addr.s_addr, conn->addr.sin_port,
+                      conn->rx_frame->data, conn->rx_frame->len);
+    process_frame(conn->rx_frame->data, conn->rx_frame->len);
+    conn->got = 0;
+}
+
+// Close a connection and free its slot; a trailing partial frame is reported as malformed
+static void portable_close(portable_conn_t *conn)
+{
+    if (conn->got > 0)
+        portable_frame(conn);
+    frame_free(conn->rx_frame);
+    capture_flush(capture);
+
+    #ifdef _WIN32
+    closesocket(conn->fd);
+    #else
+    close(conn->fd);
+    #endif
+    conn->fd = -1;
+}
+
+/*
+ * Function to accept one client connection into a free slot. If all PORTABLE_MAX_CONNS slots are
+ * taken, the connection that has been idle longest is closed to make room once it has been idle for
+ * PORTABLE_IDLE_EVICT_MS, so silent or half-open peers cannot lock out the others; otherwise the
+ * new connection is refused and the sender fails over or retries.
+ * server_fd: Listening socket
+ */
+static void portable_accept(int server_fd)
+{
+    struct sockaddr_in addr;
+    socklen_t addr_len = sizeof(addr);
+    portable_conn_t *conn = NULL;
+
+    int fd = accept(server_fd, (struct sockaddr *)&addr, &addr_len);
+    if (fd == -1)
+    {
+        if (!stop_requested)
             perror("accept");
-            continue;
-        }
+        return;
+    }
 
-        // Allocate buffer for incoming data
-        buffer = (unsigned char *)malloc(BUFFER_SIZE);
-        if (buffer == NULL)
+    for (int i = 0; i < PORTABLE_MAX_CONNS; i++)
+    {
+        if (portable_conns[i].fd == -1)
         {
-            perror("malloc failed for buffer");
+            conn = &portable_conns[i];
+            break;
+        }
+        if (conn == NULL || portable_conns[i].last_rx_ns < conn->last_rx_ns)
+            conn = &portable_conns[i];
+    }
+    if (conn->fd != -1)
+    {
+        if (reorder_now_ns() - conn->last_rx_ns < PORTABLE_IDLE_EVICT_MS * 1000000ull)
+        {
+            fprintf(stderr, "Too many connections, refusing a new one\n");
             #ifdef _WIN32
-            closesocket(client_fd);
+            closesocket(fd);
             #else
-            close(client_fd);
+            close(fd);
             #endif
-            continue;
+            return;
         }
+        fprintf(stderr, "Too many connections, closing the longest idle one\n");
+        portable_close(conn);
+    }
 
-        // Clear buffer before receiving data
-        memset(buffer, 0, BUFFER_SIZE);
+    // Take a receive buffer from the frame pool
+    conn->rx_frame = frame_alloc(BUFFER_SIZE);
+    if (conn->rx_frame == NULL)
+    {
+        fprintf(stderr, "Frame pool exhausted, dropping connection\n");
+        #ifdef _WIN32
+        closesocket(fd);
+        #else
+        close(fd);
+        #endif
+        return;
+    }
+    conn->fd = fd;
+    conn->addr = addr;
+    conn->got = 0;
+    conn->last_rx_ns = reorder_now_ns();
+}
 
-        // Receive data from client
-        bytes_received = recv(client_fd, buffer, BUFFER_SIZE, 0);
-        printf("Received %d bytes from client\n", bytes_received);
+/*
+ * Function to receive what a readable connection has sent; processes every frame it completes
+ * and closes the connection at end of stream or on error
+ * conn: Connection select() reported readable
+ */
+static void portable_recv(portable_conn_t *conn)
+{
+    int n = recv(conn->fd, (char *)conn->rx_frame->data + conn->got, WIRE_FRAME_SIZE - conn->got, 0);
+    if (n <= 0)
+    {
+        if (n < 0 && !stop_requested)
+            perror("recv");
+        portable_close(conn);
+        return;
+    }
+
+    conn->last_rx_ns = reorder_now_ns();
+    conn->got += n;
+    if (conn->got == WIRE_FRAME_SIZE)
+        portable_frame(conn);
+}
+
+/*
+ * Function to run the portable receive path: one select() loop over the listening socket and up
+ * to PORTABLE_MAX_CONNS client connections, each of which may send any number of frames back to back
+ * server_fd: Listening socket
+ */
+void run_portable(int server_fd)
+{
+    for (int i = 0; i < PORTABLE_MAX_CONNS; i++)
+        portable_conns[i].fd = -1;
+
+    while (!stop_requested)
+    {
+        fd_set fds;
+        struct timeval tv;
+        int max_fd = server_fd;
 
-        if (bytes_received > 0)
+        FD_ZERO(&fds);
+        FD_SET(server_fd, &fds);
+        for (int i = 0; i < PORTABLE_MAX_CONNS; i++)
         {
-            #if ENABLE_DECRYPTION
-            // Check if received data is large enough to contain CMAC
-            if (bytes_received < CMAC_SIZE)
-            {
-                fprintf(stderr, "Received data too short for CMAC\n");
-                #ifdef _WIN32
-                closesocket(client_fd);
-                #else
-                close(client_fd);
-                #endif
-                free(buffer);
+            if (portable_conns[i].fd == -1)
                 continue;
-            }
+            FD_SET(portable_conns[i].fd, &fds);
+            if (portable_conns[i].fd > max_fd)
+                max_fd = portable_conns[i].fd;
+        }
 
-            // Extract ciphertext and CMAC from received buffer
-            int ciphertext_len = bytes_received - CMAC_SIZE;
-            unsigned char recvd_cmac[CMAC_SIZE] = {0};
+        // Only block until held samples reach their lateness bound or the counters are due
+        uint64_t deadline = receiver_tick();
+        uint64_t now = reorder_now_ns();
+        uint64_t timeout = deadline > now ? deadline - now : 0;
+        tv.tv_sec = (long)(timeout / 1000000000ull);
+        tv.tv_usec = (long)(timeout % 1000000000ull / 1000);
 
-            unsigned char *ciphertext = (unsigned char *)malloc(ciphertext_len);
-            if (NULL == ciphertext)
-            {
-                perror("malloc failed for ciphertext buffer");
-                closesocket(client_fd);
-                free(buffer);
-                continue;
-            }
+        int ready = select(max_fd + 1, &fds, NULL, NULL, &tv);
+        if (ready <= 0)
+        {
+            if (ready < 0 && !stop_requested)
+                perror("select");
+            continue;
+        }
 
-            memcpy(ciphertext, buffer, ciphertext_len);
-            memcpy(recvd_cmac, buffer + ciphertext_len, CMAC_SIZE);
-            free(buffer);
+        // Serve the clients before accepting, so a descriptor reused by the new socket is not
+        // mistaken for one select() reported readable
+        for (int i = 0; i < PORTABLE_MAX_CONNS; i++)
+        {
+            if (portable_conns[i].fd != -1 && FD_ISSET(portable_conns[i].fd, &fds))
+                portable_recv(&portable_conns[i]);
+        }
+        if (FD_ISSET(server_fd, &fds))
+            portable_accept(server_fd);
+    }
 
-            // Verify CMAC to ensure data integrity and authenticity
-            printf("Verifying CMAC...   \n");
-            int verified = verify_cmac(aes_key, ciphertext, ciphertext_len, recvd_cmac);
-            if (verified != 1)
-            {
-                fprintf(stderr, /* RED */"\033[1;31mCMAC verification failed! Possible tampering attempt!!!\033[0m\n"/* RESET */);
-                #ifdef _WIN32
-                closesocket(client_fd);
-                #else
-                close(client_fd);
-                #endif
-                free(ciphertext);
-                continue;
-            }
-            printf("\033[1;32mCMAC verification successful!!\033[0m\n");
+    for (int i = 0; i < PORTABLE_MAX_CONNS; i++)
+    {
+        if (portable_conns[i].fd != -1)
+            portable_close(&portable_conns[i]);
+    }
+}
 
-            /* Decrypt the ciphertext */
-            unsigned char *decrypted = (unsigned char *)calloc(sizeof(sensor_data_t), sizeof(unsigned char));
-            if (decrypted == NULL)
-            {
-                perror("calloc failed for decrypted data buffer");
-                free(ciphertext);
-                closesocket(client_fd);
-                continue;
-            }
+#if USE_IO_URING
+// io_uring user_data layout: operation in the upper 32 bits, socket in the lower 32 bits
+#define URING_OP_ACCEPT 1
+#define URING_OP_RECV 2
+#define URING_DATA(op, fd) (((__u64)(op) << 32) | (__u32)(fd))
+#define URING_DATA_OP(data) ((int)((data) >> 32))
+#define URING_DATA_FD(data) ((int)((data) & 0xFFFFFFFFu))
 
-            int decrypted_len = decrypt(ciphertext, ciphertext_len,
-                                        (unsigned char *)aes_key, (unsigned char *)aes_iv, decrypted);
-            free(ciphertext);
+// Per client socket state: peer address (only while capturing) and a partial frame carried
+// over from the previous completion
+typedef struct
+{
+    uint32_t addr;                        // IPv4 address, network byte order
+    uint16_t port;                        // TCP port, network byte order
+    int carry_len;                        // Bytes of an incomplete frame in carry
+    unsigned char carry[WIRE_FRAME_SIZE];
+} uring_conn_t;
+
+static uring_conn_t *uring_conns = NULL;
+static int uring_conn_count = 0;
+
+// Set up the state of a newly accepted socket, returns 0 on success, -1 on allocation failure
+static int uring_track_conn(int fd)
+{
+    struct sockaddr_in addr;
+    socklen_t addr_len = sizeof(addr);
+
+    if (fd >= uring_conn_count)
+    {
+        // Grow in steps so this only allocates while the descriptor range is still growing
+        int count = (fd + 1024) & ~1023;
+        uring_conn_t *conns = (uring_conn_t *)realloc(uring_conns, count * sizeof(uring_conn_t));
+        if (conns == NULL)
+            return -1;
+        uring_conns = conns;
+        uring_conn_count = count;
+    }
+
+    uring_conn_t *conn = &uring_conns[fd];
+    conn->addr = 0;
+    conn->port = 0;
+    conn->carry_len = 0;
+    if (capture && getpeername(fd, (struct sockaddr *)&addr, &addr_len) == 0)
+    {
+        conn->addr = addr.sin_addr.s_addr;
+        conn->port = addr.sin_port;
+    }
+    return 0;
+}
+
+// Capture and process one complete (or, at end of stream, truncated) frame of a connection
+static void uring_frame(const uring_conn_t *conn, const unsigned char *frame, int len)
+{
+    puts("------------------------------------------------------------------------------------------");
+    printf("Received %d bytes from client\n", len);
+    if (capture)
+        capture_write(capture, conn->addr, conn->port, frame, len);
+    process_frame(frame, len);
+}
+
+/*
+ * Split received bytes into frames. Complete frames are processed straight out of the
+ * kernel buffer; only a frame split across two completions is copied into the carry buffer.
+ */
+static void uring_consume(uring_conn_t *conn, const unsigned char *data, int len)
+{
+    if (conn->carry_len > 0)
+    {
+        int need = WIRE_FRAME_SIZE - conn->carry_len;
+        int take = len < need ? len : need;
+        memcpy(conn->carry + conn->carry_len, data, take);
+        conn->carry_len += take;
+        data += take;
+        len -= take;
+        if (conn->carry_len < WIRE_FRAME_SIZE)
+            return;
+        uring_frame(conn, conn->carry, WIRE_FRAME_SIZE);
+        conn->carry_len = 0;
+    }
+
+    while (len >= WIRE_FRAME_SIZE)
+    {
+        uring_frame(conn, data, WIRE_FRAME_SIZE);
+        data += WIRE_FRAME_SIZE;
+        len -= WIRE_FRAME_SIZE;
+    }
+
+    memcpy(conn->carry, data, len);
+    conn->carry_len = len;
+}
+
+// Get a free SQE, flushing the submission queue once if it is full
+static struct io_uring_sqe *uring_get_sqe(struct io_uring *ring)
+{
+    struct io_uring_sqe *sqe = io_uring_get_sqe(ring);
+    if (sqe == NULL)
+    {
+        io_uring_submit(ring);
+        sqe = io_uring_get_sqe(ring);
+    }
+    return sqe;
+}
+
+// Queue a multishot accept on the listening socket: one SQE yields a CQE per new connection
+static int uring_arm_accept(struct io_uring *ring, int server_fd)
+{
+    struct io_uring_sqe *sqe = uring_get_sqe(ring);
+    if (sqe == NULL)
+        return -1;
+
+    io_uring_prep_multishot_accept(sqe, server_fd, NULL, NULL, 0);
+    io_uring_sqe_set_data64(sqe, URING_DATA(URING_OP_ACCEPT, server_fd));
+    return 0;
+}
+
+// Queue a multishot recv on a client socket; the kernel picks a buffer from the provided buffer ring
+static int uring_arm_recv(struct io_uring *ring, int client_fd)
+{
+    struct io_uring_sqe *sqe = uring_get_sqe(ring);
+    if (sqe == NULL)
+        return -1;
+
+    io_uring_prep_recv_multishot(sqe, client_fd, NULL, 0, 0);
+    sqe->flags |= IOSQE_BUFFER_SELECT;
+    sqe->buf_group = URING_BUF_GROUP;
+    io_uring_sqe_set_data64(sqe, URING_DATA(URING_OP_RECV, client_fd));
+    return 0;
+}
+
+/*
+ * Check that the kernel supports multishot recv (Linux >= 6.0). Multishot accept and provided
+ * buffer rings already work on 5.19, where every recv would then fail with -EINVAL, so this has
+ * to be known before any client is accepted on the ring.
+ * Returns: 0 if supported, a negative errno otherwise
+ */
+static int uring_probe_recv(struct io_uring *ring)
+{
+    struct io_uring_cqe *cqe;
+    int sv[2];
+    int ret;
+
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sv) != 0)
+        return -errno;
+    // With the peer gone the recv completes at once: end of stream if supported, -EINVAL if not
+    close(sv[1]);
+    if (uring_arm_recv(ring, sv[0]) != 0)
+    {
+        close(sv[0]);
+        return -EBUSY;
+    }
+
+    ret = io_uring_submit_and_wait(ring, 1);
+    if (ret >= 0)
+    {
+        ret = io_uring_wait_cqe(ring, &cqe);
+        if (ret == 0)
+        {
+            ret = cqe->res < 0 ? cqe->res : 0;
+            io_uring_cqe_seen(ring, cqe);
+        }
+    }
+    close(sv[0]);
+    return ret;
+}
+
+/*
+ * Function to run the receiver on io_uring (Linux only)
+ * Uses multishot accept, multishot recv with a provided buffer ring and batched submission:
+ * all SQEs queued while handling a batch of CQEs are submitted with a single io_uring_enter().
+ * Frames are processed directly out of the kernel-filled buffers, which are then handed back to the ring.
+ * server_fd: Listening socket
+ * Returns: 0 once SIGINT/SIGTERM asked the receiver to stop,
+ *          -1 if io_uring is unavailable or failed, so the caller can fall back to the portable path
+ */
+int run_io_uring(int server_fd)
+{
+    struct io_uring ring;
+    struct io_uring_buf_ring *buf_ring = NULL;
+    unsigned char *bufs = NULL;
+    const int buf_mask = io_uring_buf_ring_mask(URING_BUF_COUNT);
+    int accepted = 0;
+    int ret;
+
+    ret = io_uring_queue_init(URING_QUEUE_DEPTH, &ring, 0);
+    if (ret < 0)
+    {
+        fprintf(stderr, "io_uring_queue_init failed: %s\n", strerror(-ret));
+        return -1;
+    }
+
+    // Register the provided buffer ring (kernel >= 5.19)
+    buf_ring = io_uring_setup_buf_ring(&ring, URING_BUF_COUNT, URING_BUF_GROUP, 0, &ret);
+    if (buf_ring == NULL)
+    {
+        fprintf(stderr, "io_uring_setup_buf_ring failed: %s\n", strerror(-ret));
+        io_uring_queue_exit(&ring);
+        return -1;
+    }
+
+    bufs = (unsigned char *)malloc((size_t)URING_BUF_COUNT * BUFFER_SIZE);
+    if (bufs == NULL)
+    {
+        perror("malloc failed for io_uring buffers");
+        io_uring_free_buf_ring(&ring, buf_ring, URING_BUF_COUNT, URING_BUF_GROUP);
+        io_uring_queue_exit(&ring);
+        return -1;
+    }
+
+    for (int i = 0; i < URING_BUF_COUNT; i++)
+    {
+        io_uring_buf_ring_add(buf_ring, bufs + (size_t)i * BUFFER_SIZE, BUFFER_SIZE, i, buf_mask, i);
+    }
+    io_uring_buf_ring_advance(buf_ring, URING_BUF_COUNT);
+
+    ret = uring_probe_recv(&ring);
+    if (ret < 0)
+    {
+        fprintf(stderr, "io_uring multishot recv not supported: %s\n", strerror(-ret));
+        ret = -1;
+        goto cleanup;
+    }
+
+    if (uring_arm_accept(&ring, server_fd) != 0)
+    {
+        fprintf(stderr, "Failed to queue io_uring accept\n");
+        ret = -1;
+        goto cleanup;
+    }
+
+    printf("Using io_uring receive path (%d x %d byte buffers)\n", URING_BUF_COUNT, BUFFER_SIZE);
+
+    while (1)
+    {
+        struct io_uring_cqe *cqe;
+        unsigned head;
+        unsigned count = 0;
+
+        if (stop_requested)
+        {
+            ret = 0;
+            goto cleanup;
+        }
+        uint64_t deadline = receiver_tick();
+
+        // Submit everything queued by the previous batch and wait for at least one completion,
+        // or only until held samples reach their lateness bound or the counters are due
+        uint64_t now = reorder_now_ns();
+        uint64_t timeout = deadline > now ? deadline - now : 0;
+        struct __kernel_timespec ts = {(long long)(timeout / 1000000000ull), (long long)(timeout % 1000000000ull)};
+        ret = io_uring_submit_and_wait_timeout(&ring, &cqe, 1, &ts, NULL);
+        if (ret < 0 && ret != -EINTR && ret != -ETIME)
+        {
+            fprintf(stderr, "io_uring_submit_and_wait failed: %s\n", strerror(-ret));
+            goto cleanup;
+        }
+
+        io_uring_for_each_cqe(&ring, head, cqe)
+        {
+            int op = URING_DATA_OP(io_uring_cqe_get_data64(cqe));
+            int fd = URING_DATA_FD(io_uring_cqe_get_data64(cqe));
+            int more = cqe->flags & IORING_CQE_F_MORE;
+            count++;
 
-            if (decrypted_len < 0)
+            if (op == URING_OP_ACCEPT)
             {
-                fprintf(stderr, "Decryption failed!!\n");
-                free(decrypted);
-                closesocket(client_fd);
-                continue;
+                if (cqe->res >= 0)
+                {
+                    accepted = 1;
+                    if (uring_track_conn(cqe->res) != 0 || uring_arm_recv(&ring, cqe->res) != 0)
+                    {
+                        fprintf(stderr, "Failed to queue io_uring recv\n");
+                        close(cqe->res);
+                    }
+                }
+                else if (!accepted && cqe->res == -EINVAL)
+                {
+                    // Multishot accept not supported by this kernel
+                    fprintf(stderr, "io_uring multishot accept not supported\n");
+                    ret = -1;
+                    goto cleanup;
+                }
+                else
+                {
+                    fprintf(stderr, "accept: %s\n", strerror(-cqe->res));
+                }
+
+                if (!more && uring_arm_accept(&ring, fd) != 0)
+                {
+                    fprintf(stderr, "Failed to re-queue io_uring accept\n");
+                    ret = -1;
+                    goto cleanup;
+                }
             }
-            // Check if the decrypted data size matches the expected structure size.
-            // This is important to detect protocol errors or incorrect padding after decryption.
-            if (decrypted_len != sizeof(sensor_data_t))
+            else if (op == URING_OP_RECV)
             {
-                fprintf(stderr, "Decrypted data size mismatch: expected %zu, got %d\n", sizeof(sensor_data_t), decrypted_len);
-                free(decrypted);
-                closesocket(client_fd);
-                continue;
+                if (cqe->res > 0 && (cqe->flags & IORING_CQE_F_BUFFER))
+                {
+                    unsigned bid = cqe->flags >> IORING_CQE_BUFFER_SHIFT;
+                    unsigned char *buf = bufs + (size_t)bid * BUFFER_SIZE;
+
+                    uring_consume(&uring_conns[fd], buf, cqe->res);
+
+                    // Hand the buffer back to the kernel
+                    io_uring_buf_ring_add(buf_ring, buf, BUFFER_SIZE, bid, buf_mask, 0);
+                    io_uring_buf_ring_advance(buf_ring, 1);
+                }
+                else if (cqe->res < 0 && cqe->res != -ENOBUFS)
+                {
+                    fprintf(stderr, "recv: %s\n", strerror(-cqe->res));
+                }
+
+                if (!more)
+                {
+                    // The kernel may end a multishot recv on a live connection: after data (e.g. on CQ
+                    // overflow) or with -ENOBUFS when every provided buffer is in use. Re-arm it then;
+                    // only end of stream (res == 0) or a real error closes the socket.
+                    if ((cqe->res > 0 || cqe->res == -ENOBUFS) && uring_arm_recv(&ring, fd) == 0)
+                        continue;
+                    // Peer closed the connection: a trailing partial frame is reported as malformed
+                    if (uring_conns[fd].carry_len > 0)
+                        uring_frame(&uring_conns[fd], uring_conns[fd].carry, uring_conns[fd].carry_len);
+                    close(fd);
+                    capture_flush(capture);
+                }
             }
+        }
+        io_uring_cq_advance(&ring, count);
+    }
 
-            // Copy decrypted data into sensor_data structure
-            memcpy(&sensor_data, (sensor_data_t *)decrypted, decrypted_len);
-            free(decrypted);
-            #else
-            // If not decrypting, expect raw sensor_data_t structure
-            if (bytes_received != sizeof(sensor_data_t))
+cleanup:
+    io_uring_free_buf_ring(&ring, buf_ring, URING_BUF_COUNT, URING_BUF_GROUP);
+    io_uring_queue_exit(&ring);
+    free(bufs);
+    free(uring_conns);
+    uring_conns = NULL;
+    uring_conn_count = 0;
+    return stop_requested ? 0 : -1;
+}
+#endif
+
+int main(int argc, char *argv[])
+{
+    int server_fd;
+    struct sockaddr_in server_addr;
+    int port = TCP_PORT;
+
+#ifdef _WIN32
+    // Initialize Winsock on Windows
+    WSADATA wsaData;
+    if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+    {
+        fprintf(stderr, "WSAStartup failed.\n");
+        return EXIT_FAILURE;
+    }
+#endif
+
+    // Command line: listen port, optional raw frame capture for offline replay (see tcp_replay.c)
+    // and the switch that passes samples through unordered
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "-p") == 0 && i + 1 < argc)
+        {
+            // Listen port, so several receivers can run on one host
+            port = atoi(argv[++i]);
+            if (port <= 0 || port > 65535)
             {
-                fprintf(stderr, "Received data size mismatch: expected %zu, got %d\n", sizeof(sensor_data_t), bytes_received);
-                closesocket(client_fd);
-                free(buffer);
-                continue;
+                fprintf(stderr, "Invalid port: %s\n", argv[i]);
+                return EXIT_FAILURE;
             }
-            memcpy(&sensor_data, buffer, sizeof(sensor_data_t));
-            #endif
-            // Print decrypted sensor data
-            printf("Decrypted Sensor Data:: ");
-            printf("Temperature: %.1f°C, Speed: %.1f km/h, GPS: (%.4f, %.4f)\n",
-                   sensor_data.temperature, sensor_data.speed,
-                   sensor_data.latitude, sensor_data.longitude);
+        }
+        else if (strcmp(argv[i], "-w") == 0 && i + 1 < argc)
+        {
+            capture = capture_open(argv[++i]);
+            if (capture == NULL)
+                return EXIT_FAILURE;
+            printf("Capturing inbound frames to %s\n", argv[i]);
+        }
+        else if (strcmp(argv[i], "-u") == 0)
+        {
+            // A replayed sample repeats the seq and timestamp of the original, so a receiver that
+            // already saw the original would drop every one of them as late
+            reorder_enabled = 0;
+            printf("Reordering disabled, samples are printed in arrival order\n");
         }
         else
         {
-            perror("recv");
-            fprintf(stderr, "recv returned %d bytes (error or connection closed)\n", bytes_received);
-            free(buffer);
+            fprintf(stderr, "Usage: %s [-p port] [-w capture_file] [-u]\n", argv[0]);
+            return EXIT_FAILURE;
         }
+    }
 
-        #ifdef _WIN32
-        closesocket(client_fd); // close connection after one message
-        #else
-        close(client_fd); // close connection after one message
-        #endif
+    // Preallocate all receive, ciphertext and plaintext buffers
+    if (frame_pool_init() != 0)
+    {
+        fprintf(stderr, "Failed to initialize frame pool\n");
+        return EXIT_FAILURE;
     }
 
+    // Preallocate the per-sensor reorder tables; samples leave them in order to print_sample()
+    if (reorder_init(print_sample) != 0)
+    {
+        fprintf(stderr, "Failed to initialize reorder stage\n");
+        return EXIT_FAILURE;
+    }
+    next_stats_ns = reorder_now_ns() + REORDER_STATS_INTERVAL_MS * 1000000ull;
+
+    // Create a TCP socket
+    server_fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (server_fd == -1)
+    {
+        perror("socket");
+        exit(EXIT_FAILURE);
+    }
+
+    // Setup server address structure
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(port);
+    server_addr.sin_addr.s_addr = INADDR_ANY;
+
+    // Bind socket to the specified port
+    if (bind(server_fd, (struct sockaddr *)&server_addr, sizeof(server_addr)) == -1)
+    {
+        perror("bind");
+#ifdef _WIN32
+        closesocket(server_fd);
+#else
+        close(server_fd);
+#endif
+        exit(EXIT_FAILURE);
+    }
+
+    // Start listening for incoming connections
+    if (listen(server_fd, LISTEN_BACKLOG) == -1)
+    {
+        perror("listen");
+        closesocket(server_fd);
+        exit(EXIT_FAILURE);
+    }
+
+    printf("TCP Receiver started. Listening on port %d...\n", port);
+
+    // Stop cleanly on SIGINT/SIGTERM so buffered capture records reach the file
+#ifdef _WIN32
+    signal(SIGINT, on_stop_signal);
+    signal(SIGTERM, on_stop_signal);
+#else
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_stop_signal;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = 0; // No SA_RESTART: a blocked accept, recv or select returns with EINTR
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+#endif
+
+#if USE_IO_URING
+    // Only returns when stopped, or if io_uring is unavailable or failed
+    if (run_io_uring(server_fd) != 0)
+        fprintf(stderr, "Falling back to portable receive path\n");
+#endif
+
+    // Main server loop: serve the client connections until stopped
+    run_portable(server_fd);
+
     #ifdef _WIN32
     closesocket(server_fd);
     #else
@@ -341,5 +994,10 @@ int main()
     WSACleanup();
     #endif
 
+    // Release what is still held, then print the final counters
+    reorder_destroy();
+    if (reorder_enabled)
+        reorder_print_stats();
+    capture_close(capture);
     return 0;
 }
@@ -0,0 +1,363 @@
+/**
+ * * @file tcp_replay.c
+ * * @brief Replays a capture recorded by tcp_receiver -w back into a running tcp_receiver.
+ * * * Every captured frame is sent over TCP exactly as it was received, so it goes through the
+ * * * receiver's real parse, CMAC verification and decryption path. Frames are paced by their recorded
+ * * * arrival times at 1x, at N times that speed, or sent as fast as possible, over one or several
+ * * * concurrent connections. Each connection is opened once and carries its frames back to back, so
+ * * * the replay loads the receive pipeline rather than connection setup.
+ * * * Frames are spread over the connections by -m, and each connection sends its frames in capture order:
+ * * *   addr   by captured peer address (default): a host's frames, across its reconnects too, keep their order
+ * * *   conn   by captured peer address and port: spreads one host's connections, and only the frames of
+ * * *          each captured connection keep their order
+ * * *   frame  round-robin per frame: spreads evenly, but gives no order across connections
+ * * * @note Replayed samples carry the sequence numbers and timestamps of the originals, so a receiver
+ * * *       that has already seen them, e.g. the one that recorded the capture or any loop after the first,
+ * * *       drops them all as late. Start the receiver with -u to bypass its reorder stage.
+ * * * @note Build with: gcc tcp_replay.c capture.c -o tcp_replay -lpthread (Linux / QNX)
+ * * * @note Usage: tcp_replay [-a ip] [-p port] [-s speed] [-c connections] [-m addr|conn|frame] [-n loops] capture_file
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <signal.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include "config.h"
+#include "capture.h"
+
+#define REPLAY_MAX_CONNECTIONS 256
+
+// One captured frame, loaded into memory before the replay starts
+typedef struct
+{
+    uint64_t offset_ns;    // Arrival time relative to the first record
+    unsigned int worker;   // Connection that sends this frame
+    unsigned int len;      // Frame length
+    size_t data;           // Offset of the frame bytes in the data blob
+} replay_record_t;
+
+// How frames are spread over the sender connections (-m)
+typedef enum
+{
+    SPREAD_ADDR,  // By captured peer address
+    SPREAD_CONN,  // By captured peer address and port
+    SPREAD_FRAME  // Round-robin per frame
+} replay_spread_t;
+
+typedef struct
+{
+    unsigned int id;
+    int sockfd;            // Persistent connection to the receiver, -1 until connected
+    unsigned long sent;    // Frames sent
+    unsigned long failed;  // Frames that could not be sent
+    unsigned long long bytes;
+    uint64_t max_late_ns;  // Worst lag behind the paced schedule
+} replay_worker_t;
+
+static struct sockaddr_in target;
+static replay_record_t *records = NULL;
+static size_t record_count = 0;
+static unsigned char *blob = NULL;
+static double speed = 1.0;             // 0 = as fast as possible
+static unsigned int loops = 1;
+static struct timespec start_time;     // Common CLOCK_MONOTONIC start of the replay
+static uint64_t capture_span_ns = 0;   // Offset of the last record, used to chain loops
+
+static uint64_t timespec_ns(const struct timespec *ts)
+{
+    return (uint64_t)ts->tv_sec * 1000000000ull + (uint64_t)ts->tv_nsec;
+}
+
+/*
+ * Function to load a whole capture into memory so file I/O does not disturb the pacing
+ * path: Capture file
+ * connections: Number of sender connections the records are spread over
+ * spread: How the records are assigned to the connections
+ * Returns: 0 on success, -1 on error
+ */
+static int load_capture(const char *path, unsigned int connections, replay_spread_t spread)
+{
+    capture_record_t rec;
+    unsigned char *frame = NULL;
+    size_t record_cap = 0, blob_len = 0, blob_cap = 0;
+    uint64_t first_ns = 0;
+    int ret;
+
+    FILE *fp = capture_open_read(path);
+    if (fp == NULL)
+        return -1;
+
+    frame = (unsigned char *)malloc(CAPTURE_MAX_FRAME);
+    if (frame == NULL)
+    {
+        perror("malloc failed for frame buffer");
+        fclose(fp);
+        return -1;
+    }
+
+    while ((ret = capture_read(fp, &rec, frame)) == 1)
+    {
+        if (record_count == record_cap)
+        {
+            record_cap = record_cap ? record_cap * 2 : 4096;
+            replay_record_t *grown = (replay_record_t *)realloc(records, record_cap * sizeof(replay_record_t));
+            if (grown == NULL)
+            {
+                perror("realloc failed for records");
+                ret = -1;
+                break;
+            }
+            records = grown;
+        }
+        if (blob_len + rec.len > blob_cap)
+        {
+            blob_cap = blob_cap ? blob_cap * 2 : 1 << 20;
+            while (blob_len + rec.len > blob_cap)
+                blob_cap *= 2;
+            unsigned char *grown = (unsigned char *)realloc(blob, blob_cap);
+            if (grown == NULL)
+            {
+                perror("realloc failed for frame data");
+                ret = -1;
+                break;
+            }
+            blob = grown;
+        }
+
+        if (record_count == 0)
+            first_ns = rec.timestamp_ns;
+
+        replay_record_t *r = &records[record_count++];
+        // Clock steps backwards on the capturing host must not reorder the schedule
+        r->offset_ns = rec.timestamp_ns > first_ns ? rec.timestamp_ns - first_ns : 0;
+        if (record_count > 1 && r->offset_ns < records[record_count - 2].offset_ns)
+            r->offset_ns = records[record_count - 2].offset_ns;
+        // Host order first, so hosts that differ only in the last octet still spread out
+        if (spread == SPREAD_FRAME)
+            r->worker = (unsigned int)((record_count - 1) % connections);
+        else if (spread == SPREAD_CONN)
+            r->worker = (((ntohl(rec.peer_addr) ^ ntohs(rec.peer_port) * 40503u) * 2654435761u) >> 16) % connections;
+        else
+            r->worker = ((ntohl(rec.peer_addr) * 2654435761u) >> 16) % connections;
+        r->len = rec.len;
+        r->data = blob_len;
+        memcpy(blob + blob_len, frame, rec.len);
+        blob_len += rec.len;
+    }
+
+    free(frame);
+    fclose(fp);
+
+    if (ret < 0)
+    {
+        fprintf(stderr, "Capture truncated or corrupt after %zu records\n", record_count);
+        if (record_count == 0)
+            return -1;
+    }
+    if (record_count > 0)
+        capture_span_ns = records[record_count - 1].offset_ns;
+    return 0;
+}
+
+// Send one frame on the worker's connection, connecting first if needed; a failed connection is
+// closed and reopened for the next frame
+static int send_frame(replay_worker_t *w, const unsigned char *data, unsigned int len)
+{
+    if (w->sockfd == -1)
+    {
+        int nodelay = 1;
+        w->sockfd = socket(AF_INET, SOCK_STREAM, 0);
+        if (w->sockfd == -1)
+            return -1;
+        if (connect(w->sockfd, (struct sockaddr *)&target, sizeof(target)) == -1)
+        {
+            close(w->sockfd);
+            w->sockfd = -1;
+            return -1;
+        }
+        // Paced frames go out when due instead of waiting to be coalesced
+        setsockopt(w->sockfd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+    }
+
+    for (unsigned int off = 0; off < len;)
+    {
+        ssize_t n = send(w->sockfd, data + off, len - off, 0);
+        if (n <= 0)
+        {
+            close(w->sockfd);
+            w->sockfd = -1;
+            return -1;
+        }
+        off += (unsigned int)n;
+    }
+    return 0;
+}
+
+static void *replay_worker(void *arg)
+{
+    replay_worker_t *w = (replay_worker_t *)arg;
+    uint64_t start_ns = timespec_ns(&start_time);
+
+    for (unsigned int loop = 0; loop < loops; loop++)
+    {
+        for (size_t i = 0; i < record_count; i++)
+        {
+            const replay_record_t *r = &records[i];
+            if (r->worker != w->id)
+                continue;
+
+            if (speed > 0)
+            {
+                // Sleep to an absolute deadline so pacing errors do not accumulate
+                uint64_t due_ns = start_ns + (uint64_t)((loop * (capture_span_ns + 1) + r->offset_ns) / speed);
+                struct timespec due = {(time_t)(due_ns / 1000000000ull), (long)(due_ns % 1000000000ull)};
+                struct timespec now;
+
+                while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &due, NULL) == EINTR)
+                    ;
+                clock_gettime(CLOCK_MONOTONIC, &now);
+                if (timespec_ns(&now) - due_ns > w->max_late_ns)
+                    w->max_late_ns = timespec_ns(&now) - due_ns;
+            }
+
+            if (send_frame(w, blob + r->data, r->len) == 0)
+            {
+                w->sent++;
+                w->bytes += r->len;
+            }
+            else
+            {
+                w->failed++;
+            }
+        }
+    }
+    if (w->sockfd != -1)
+        close(w->sockfd);
+    return NULL;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "Usage: %s [-a ip] [-p port] [-s speed] [-c connections] [-m addr|conn|frame] [-n loops] capture_file\n"
+                    "  -a ip           receiver address (default 127.0.0.1)\n"
+                    "  -p port         receiver port (default %d)\n"
+                    "  -s speed        1 = recorded pace, N = N times faster, 0 = as fast as possible (default 1)\n"
+                    "  -c connections  concurrent persistent sender connections (default 1, max %d)\n"
+                    "  -m spread       frames per connection: addr = by captured peer address (default),\n"
+                    "                  conn = by captured peer address and port, frame = round-robin;\n"
+                    "                  order is kept only among the frames that share a connection\n"
+                    "  -n loops        replay the capture this many times (default 1)\n"
+                    "Replayed samples repeat their original sequence numbers: start the receiver with -u\n"
+                    "so its reorder stage does not drop them as late.\n",
+            prog, TCP_PORT, REPLAY_MAX_CONNECTIONS);
+}
+
+int main(int argc, char *argv[])
+{
+    const char *ip = "127.0.0.1";
+    int port = TCP_PORT;
+    unsigned int connections = 1;
+    replay_spread_t spread = SPREAD_ADDR;
+    const char *path = NULL;
+    pthread_t threads[REPLAY_MAX_CONNECTIONS];
+    replay_worker_t workers[REPLAY_MAX_CONNECTIONS];
+    struct timespec end_time;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "a:p:s:c:m:n:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'a': ip = optarg; break;
+        case 'p': port = atoi(optarg); break;
+        case 's': speed = strtod(optarg, NULL); break;
+        case 'c': connections = (unsigned int)atoi(optarg); break;
+        case 'm':
+            if (strcmp(optarg, "addr") == 0)
+                spread = SPREAD_ADDR;
+            else if (strcmp(optarg, "conn") == 0)
+                spread = SPREAD_CONN;
+            else if (strcmp(optarg, "frame") == 0)
+                spread = SPREAD_FRAME;
+            else
+            {
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+            break;
+        case 'n': loops = (unsigned int)atoi(optarg); break;
+        default: usage(argv[0]); return EXIT_FAILURE;
+        }
+    }
+    if (optind != argc - 1 || connections < 1 || connections > REPLAY_MAX_CONNECTIONS || speed < 0 || loops < 1)
+    {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    path = argv[optind];
+    // A receiver closing a connection must fail that send, not kill the replay
+    signal(SIGPIPE, SIG_IGN);
+
+    memset(&target, 0, sizeof(target));
+    target.sin_family = AF_INET;
+    target.sin_port = htons(port);
+    if (inet_pton(AF_INET, ip, &target.sin_addr) != 1)
+    {
+        fprintf(stderr, "Invalid receiver address: %s\n", ip);
+        return EXIT_FAILURE;
+    }
+
+    if (load_capture(path, connections, spread) != 0)
+        return EXIT_FAILURE;
+    printf("Loaded %zu frames spanning %.3f s from %s\n", record_count, capture_span_ns / 1e9, path);
+    if (speed > 0)
+        printf("Replaying to %s:%d at %gx over %u connection(s), %u loop(s)...\n", ip, port, speed, connections, loops);
+    else
+        printf("Replaying to %s:%d at maximum speed over %u connection(s), %u loop(s)...\n", ip, port, connections, loops);
+
+    clock_gettime(CLOCK_MONOTONIC, &start_time);
+    for (unsigned int i = 0; i < connections; i++)
+    {
+        memset(&workers[i], 0, sizeof(workers[i]));
+        workers[i].id = i;
+        workers[i].sockfd = -1;
+        if (pthread_create(&threads[i], NULL, replay_worker, &workers[i]) != 0)
+        {
+            perror("pthread_create");
+            return EXIT_FAILURE;
+        }
+    }
+
+    unsigned long sent = 0, failed = 0;
+    unsigned long long bytes = 0;
+    uint64_t max_late_ns = 0;
+    for (unsigned int i = 0; i < connections; i++)
+    {
+        pthread_join(threads[i], NULL);
+        sent += workers[i].sent;
+        failed += workers[i].failed;
+        bytes += workers[i].bytes;
+        if (workers[i].max_late_ns > max_late_ns)
+            max_late_ns = workers[i].max_late_ns;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end_time);
+
+    double elapsed = (timespec_ns(&end_time) - timespec_ns(&start_time)) / 1e9;
+    printf("Sent %lu frames (%llu bytes), %lu failed, in %.3f s: %.0f frames/s, %.2f MB/s\n",
+           sent, bytes, failed, elapsed, elapsed > 0 ? sent / elapsed : 0.0,
+           elapsed > 0 ? bytes / elapsed / 1e6 : 0.0);
+    if (speed > 0)
+        printf("Worst lag behind schedule: %.3f ms\n", max_late_ns / 1e6);
+
+    free(records);
+    free(blob);
+    return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}